@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Where AudioThread sends its samples: 16-bit signed mono PCM
+ */
+class AudioSink {
+    public:
+        virtual ~AudioSink() = default;
+
+        virtual unsigned sampleRate() const = 0;
+
+        /**
+         * Called on the audio thread only, must not block for long
+         */
+        virtual void write(const std::int16_t* samples, std::size_t count) = 0;
+
+        //times the output device asked for samples that were not there yet
+        virtual std::uint64_t underruns() const { return 0; }
+        //samples thrown away because the output device could not keep up
+        virtual std::uint64_t overruns() const { return 0; }
+};
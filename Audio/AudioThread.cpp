@@ -0,0 +1,114 @@
+#include "AudioThread.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+AudioThread::AudioThread(AudioSink& sink, double frequency) : sink(sink), frequency(frequency) {}
+
+AudioThread::~AudioThread() {
+    stop();
+}
+
+void AudioThread::start() {
+    if(thread.joinable()) return;
+    stopping = false;
+    thread = std::thread(&AudioThread::threadLoop, this);
+}
+
+void AudioThread::stop() {
+    if(!thread.joinable()) return;
+    stopping = true;
+    thread.join();
+}
+
+void AudioThread::threadLoop() {
+    while(!stopping.load(std::memory_order_acquire)) {
+        //a millisecond is far below the latency of any output device
+        if(!renderPending()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    //whatever was published before stop() still reaches the sink
+    while(renderPending()) {}
+}
+
+bool AudioThread::renderPending() {
+    unsigned rate = sink.sampleRate();
+    std::uint64_t target = static_cast<std::uint64_t>(publishedCycle.load(std::memory_order_acquire) * rate / frequency);
+    std::uint64_t rendered = samplesRendered.load(std::memory_order_relaxed);
+    if(rendered >= target) return false;
+
+    std::array<std::int16_t, CHUNK_SIZE> buffer;
+    std::size_t count = std::min<std::uint64_t>(CHUNK_SIZE, target - rendered);
+    for(std::size_t i = 0; i < count; i++) {
+        //events are published before the time they start at, so the next one is always in the ring
+        const SoundEvent* next;
+        while((next = events.peek()) != nullptr && static_cast<std::uint64_t>(next->cycle * rate / frequency) <= rendered + i) {
+            events.pop(current);
+        }
+        buffer[i] = nextSample();
+    }
+    sink.write(buffer.data(), count);
+    samplesRendered.store(rendered + count, std::memory_order_relaxed);
+    return true;
+}
+
+std::int16_t AudioThread::nextSample() {
+    if(!current.on) {
+        //the next tone starts on a rising edge, no click from a random phase
+        phase = 0;
+        return 0;
+    }
+
+    if(!current.pattern) {
+        phase += BEEPER_HZ / sink.sampleRate();
+        phase -= std::floor(phase);
+        return phase < 0.5 ? AMPLITUDE : -AMPLITUDE;
+    }
+
+    //XO-CHIP plays the 128 bit pattern at 4000 * 2 ^ ((pitch - 64) / 48) bits per second
+    double bitsPerSecond = 4000 * std::exp2((current.pitch - 64) / 48.0);
+    phase += bitsPerSecond / sink.sampleRate();
+    phase -= std::floor(phase / 128) * 128;
+    unsigned bit = static_cast<unsigned>(phase);
+    bool high = (current.samples[bit / 8] >> (7 - bit % 8)) & 1u;
+    return high ? AMPLITUDE : -AMPLITUDE;
+}
+
+void AudioThread::frame(const Chip8& chip8, std::uint64_t cycles, bool audible) {
+    producerCycle += cycles;
+
+    SoundEvent event;
+    event.cycle = producerCycle;
+    event.on = audible && chip8.sound_timer > 0;
+    event.pattern = chip8.quirks == QuirkProfile::XoChip;
+    event.pitch = chip8.pitch;
+    event.samples = chip8.audioPattern;
+
+    bool changed = event.on != lastPushed.on || event.pattern != lastPushed.pattern ||
+                   event.pitch != lastPushed.pitch || event.samples != lastPushed.samples;
+    if(changed) {
+        bool pushed = events.push(event);
+        while(!pushed && lossless) {
+            std::this_thread::yield();
+            pushed = events.push(event);
+        }
+        //a dropped change is pushed again with the next frame
+        if(pushed) lastPushed = event;
+        else droppedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    publishedCycle.store(producerCycle, std::memory_order_release);
+}
+
+void AudioThread::setLossless(bool enabled) {
+    lossless = enabled;
+}
+
+AudioStats AudioThread::getStats() const {
+    AudioStats stats;
+    stats.samplesRendered = samplesRendered.load(std::memory_order_relaxed);
+    stats.droppedEvents = droppedEvents.load(std::memory_order_relaxed);
+    stats.underruns = sink.underruns();
+    stats.overruns = sink.overruns();
+    return stats;
+}
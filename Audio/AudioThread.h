@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include "AudioSink.h"
+#include "Chip8.h"
+#include "SpscRing.h"
+
+/**
+ * The sound state from an emulated instruction onwards
+ */
+struct SoundEvent {
+    //instructions since the AudioThread started
+    std::uint64_t cycle{};
+    //the sound timer is running
+    bool on{false};
+    //play the XO-CHIP pattern at the pitch instead of the plain beeper
+    bool pattern{false};
+    std::uint8_t pitch{64};
+    std::array<std::uint8_t, 16> samples{};
+};
+
+struct AudioStats {
+    std::uint64_t samplesRendered{};
+    //events lost because the ring was full
+    std::uint64_t droppedEvents{};
+    //reported by the sink
+    std::uint64_t underruns{};
+    std::uint64_t overruns{};
+};
+
+/**
+ * Synthesizes the beeper and the XO-CHIP pattern audio on its own thread.
+ *
+ * The emulation thread calls frame() after every emulated frame. It pushes an event
+ * into a lock-free ring when the sound state changed and publishes how far emulated time got,
+ * it never waits for the audio thread. The audio thread renders samples up to that point,
+ * so the sound follows emulated time and the output device only ever sees whole frames.
+ * Sound changes take effect at frame boundaries, the resolution of the sound timer itself.
+ */
+class AudioThread {
+    private:
+        const static std::size_t EVENT_CAPACITY = 1024;
+        //samples rendered per sink write
+        constexpr static std::size_t CHUNK_SIZE = 512;
+
+        const static std::int16_t AMPLITUDE = 6000;
+        //tone of the plain beeper
+        constexpr static double BEEPER_HZ = 440;
+
+        AudioSink& sink;
+        double frequency;
+
+        SpscRing<SoundEvent, EVENT_CAPACITY> events;
+        //end of the emulated time the audio thread may render
+        std::atomic<std::uint64_t> publishedCycle{0};
+        std::atomic<std::uint64_t> droppedEvents{0};
+        std::atomic<std::uint64_t> samplesRendered{0};
+        std::atomic<bool> stopping{false};
+        std::thread thread;
+
+        //producer side
+        std::uint64_t producerCycle{};
+        SoundEvent lastPushed;
+        bool lossless{false};
+
+        //consumer side
+        SoundEvent current;
+        double phase{};
+
+        void threadLoop();
+        //render up to publishedCycle, false if there was nothing to do
+        bool renderPending();
+        std::int16_t nextSample();
+
+    public:
+        /**
+         * @param frequency: Emulated instructions per second, converts instructions to samples
+         */
+        AudioThread(AudioSink& sink, double frequency);
+        ~AudioThread();
+
+        AudioThread(const AudioThread&) = delete;
+        AudioThread& operator=(const AudioThread&) = delete;
+
+        void start();
+
+        /**
+         * Render everything published so far and join the thread
+         */
+        void stop();
+
+        /**
+         * Emulation thread: the frame of the given length was emulated, chip8 is the state at its end
+         * @param audible: false to output silence, e.g. while rewinding or in turbo mode
+         */
+        void frame(const Chip8& chip8, std::uint64_t cycles, bool audible = true);
+
+        /**
+         * Wait for the audio thread when the ring is full instead of dropping events,
+         * for offline rendering into a WAV file where nothing runs in real time
+         */
+        void setLossless(bool enabled);
+
+        AudioStats getStats() const;
+};
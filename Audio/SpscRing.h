@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <atomic>
+
+/**
+ * Lock-free ring buffer for exactly one producer thread and one consumer thread.
+ *
+ * The producer only writes head and the consumer only writes tail, so neither ever waits
+ * for the other: push fails when the ring is full and pop fails when it is empty.
+ * Both indices run freely and are masked on access, CAPACITY must be a power of two.
+ */
+template<typename T, std::size_t CAPACITY>
+class SpscRing {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    private:
+        std::array<T, CAPACITY> items{};
+
+        //on separate cache lines, the two threads would invalidate each other's line on every access
+        alignas(64) std::atomic<std::size_t> head{0};
+        alignas(64) std::atomic<std::size_t> tail{0};
+
+    public:
+        /**
+         * Producer thread only
+         * @return: false if the ring is full, nothing is written then
+         */
+        bool push(const T& item) {
+            std::size_t h = head.load(std::memory_order_relaxed);
+            if(h - tail.load(std::memory_order_acquire) == CAPACITY) return false;
+            items[h & (CAPACITY - 1)] = item;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Consumer thread only
+         * @return: false if the ring is empty
+         */
+        bool pop(T& item) {
+            std::size_t t = tail.load(std::memory_order_relaxed);
+            if(head.load(std::memory_order_acquire) == t) return false;
+            item = items[t & (CAPACITY - 1)];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Consumer thread only: the next item without removing it
+         * @return: nullptr if the ring is empty
+         */
+        const T* peek() const {
+            std::size_t t = tail.load(std::memory_order_relaxed);
+            if(head.load(std::memory_order_acquire) == t) return nullptr;
+            return &items[t & (CAPACITY - 1)];
+        }
+
+        //items waiting: at most this many on the producer thread, at least this many on the consumer thread
+        std::size_t size() const {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+
+        static constexpr std::size_t capacity() {
+            return CAPACITY;
+        }
+};
@@ -0,0 +1,80 @@
+#include "WavSink.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+    //WAV is little endian whatever the host is
+    void putLE(std::uint8_t* out, std::uint32_t value, std::size_t bytes) {
+        for(std::size_t i = 0; i < bytes; i++) {
+            out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+        }
+    }
+}
+
+WavSink::WavSink(unsigned sampleRate) : rate(sampleRate) {}
+
+WavSink::~WavSink() {
+    close();
+}
+
+bool WavSink::open(const std::string& filePath) {
+    close();
+    file.open(filePath, std::ios::binary | std::ios::trunc);
+    if(!file.is_open()) return false;
+    samplesWritten = 0;
+
+    //placeholder sizes, close() writes the real ones
+    std::array<std::uint8_t, HEADER_SIZE> header{};
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    return file.good();
+}
+
+bool WavSink::close() {
+    if(!file.is_open()) return false;
+
+    std::uint32_t dataSize = static_cast<std::uint32_t>(samplesWritten * 2);
+    std::array<std::uint8_t, HEADER_SIZE> header{};
+    std::uint8_t* h = header.data();
+    std::copy_n("RIFF", 4, h);
+    putLE(h + 4, 36 + dataSize, 4);
+    std::copy_n("WAVEfmt ", 8, h + 8);
+    putLE(h + 16, 16, 4);           //fmt chunk size
+    putLE(h + 20, 1, 2);            //PCM
+    putLE(h + 22, 1, 2);            //mono
+    putLE(h + 24, rate, 4);
+    putLE(h + 28, rate * 2, 4);     //bytes per second
+    putLE(h + 32, 2, 2);            //bytes per frame
+    putLE(h + 34, 16, 2);           //bits per sample
+    std::copy_n("data", 4, h + 36);
+    putLE(h + 40, dataSize, 4);
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    bool ok = file.good();
+    file.close();
+    return ok;
+}
+
+unsigned WavSink::sampleRate() const {
+    return rate;
+}
+
+void WavSink::write(const std::int16_t* samples, std::size_t count) {
+    if(!file.is_open()) return;
+    std::array<std::uint8_t, 1024> buffer;
+    while(count > 0) {
+        std::size_t chunk = std::min(count, buffer.size() / 2);
+        for(std::size_t i = 0; i < chunk; i++) {
+            putLE(&buffer[2 * i], static_cast<std::uint16_t>(samples[i]), 2);
+        }
+        file.write(reinterpret_cast<const char*>(buffer.data()), chunk * 2);
+        samples += chunk;
+        count -= chunk;
+        samplesWritten += chunk;
+    }
+}
+
+std::uint64_t WavSink::sampleCount() const {
+    return samplesWritten;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+#include "AudioSink.h"
+
+/**
+ * Writes the samples into a 16-bit mono PCM WAV file, for headless runs and tests.
+ * The header sizes are filled in by close()
+ */
+class WavSink : public AudioSink {
+    private:
+        std::ofstream file;
+        unsigned rate;
+        std::uint64_t samplesWritten{};
+
+    public:
+        const static std::size_t HEADER_SIZE = 44;
+
+        explicit WavSink(unsigned sampleRate = 44100);
+        ~WavSink() override;
+
+        /**
+         * @return: false if the file can not be created
+         */
+        bool open(const std::string& filePath);
+
+        /**
+         * Patch the header and close the file
+         * @return: false if anything could not be written
+         */
+        bool close();
+
+        unsigned sampleRate() const override;
+        void write(const std::int16_t* samples, std::size_t count) override;
+
+        std::uint64_t sampleCount() const;
+};
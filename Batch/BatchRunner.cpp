@@ -0,0 +1,150 @@
+#include "BatchRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+
+#include "AudioThread.h"
+#include "InputQueue.h"
+#include "Jit.h"
+#include "Scheduler.h"
+#include "WavSink.h"
+
+BatchRunner::BatchRunner(unsigned threads) : pool(threads) {}
+
+unsigned BatchRunner::threadCount() const {
+    return pool.size();
+}
+
+RomLibrary& BatchRunner::romLibrary() {
+    return library;
+}
+
+std::vector<BatchResult> BatchRunner::run(const std::vector<BatchJob>& jobs) {
+    std::vector<BatchResult> results(jobs.size());
+    pool.parallelFor(jobs.size(), [&](std::size_t i, unsigned) {
+        results[i] = runJob(jobs[i], library);
+    });
+    return results;
+}
+
+BatchResult BatchRunner::runJob(const BatchJob& job, RomLibrary& library) {
+    BatchResult result;
+    result.romPath = job.romPath;
+
+    RomImage rom;
+    switch(library.open(job.romPath, rom)) {
+        case FailStates::SUCCESS: break;
+        case FailStates::ROM_EMPTY: result.error = "ROM file is empty"; return result;
+        case FailStates::ROM_TOO_LARGE: result.error = "ROM does not fit in memory"; return result;
+        default: result.error = "ROM file not found"; return result;
+    }
+
+    InputLog log;
+    if(!job.inputScript.empty() && !log.load(job.inputScript)) {
+        result.error = "invalid input script";
+        return result;
+    }
+    std::uint64_t cycleBudget = log.hasEnd ? log.endCycle : job.cycleBudget;
+
+    result.quirks = log.hasQuirks ? log.quirks : job.hasQuirks ? job.quirks : rom.quirks;
+
+    Chip8 chip8(log.hasSeed ? log.seed : job.seed);
+    chip8.setEngine(job.engine);
+    chip8.setQuirks(result.quirks);
+    chip8.idleSkipping = job.idleSkipping;
+    //the library takes XO-CHIP sized ROMs, the other profiles reach only 4 KB
+    if(chip8.loadRom(rom.data, rom.size) != FailStates::SUCCESS) {
+        result.error = "ROM does not fit in memory";
+        return result;
+    }
+
+    std::unique_ptr<Jit> jit;
+    if(job.jit) {
+        jit = std::make_unique<Jit>(chip8);
+        jit->setVerify(job.verifyJit);
+    }
+
+    double frequency = log.frequency > 0 ? log.frequency : job.frequency;
+
+    //offline rendering, the emulation waits for the audio thread instead of losing sound changes
+    WavSink wav;
+    std::unique_ptr<AudioThread> audio;
+    if(!job.wavPath.empty()) {
+        if(!wav.open(job.wavPath)) {
+            result.error = "can not write the WAV file";
+            return result;
+        }
+        audio = std::make_unique<AudioThread>(wav, frequency);
+        audio->setLossless(true);
+        audio->start();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    //emulated 60 Hz frames, only used to count instructions, nothing sleeps
+    Scheduler frames(frequency);
+
+    InputQueue input;
+    for(const InputEvent& event : log.events) {
+        input.push(event);
+    }
+
+    std::uint64_t cycle = 0;
+    while(cycle < cycleBudget) {
+        std::uint64_t frameStart = cycle;
+        std::uint64_t frameEnd = std::min(cycleBudget, cycle + frames.instructionsForFrame());
+
+        //stops at every scheduled input on the way
+        input.run(chip8, frameEnd - cycle, [&](std::uint64_t instructions) {
+            if(jit) jit->run(instructions);
+            else chip8.run(instructions);
+        });
+        cycle = frameEnd;
+
+        chip8.tickTimers();
+        if(audio) audio->frame(chip8, cycle - frameStart);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    if(audio) {
+        audio->stop();
+        if(!wav.close()) {
+            result.error = "can not write the WAV file";
+            return result;
+        }
+    }
+
+    result.ok = true;
+    result.cycles = cycle;
+    result.registersHash = chip8.registersHash();
+    result.memoryHash = chip8.memoryHash();
+    result.displayHash = chip8.displayHash();
+    result.idleCycles = chip8.idleCycles;
+    if(jit) result.jitMismatches = jit->getStats().mismatches;
+#ifdef CHIP8_PROFILE
+    if(!job.profilePrefix.empty()) {
+        std::ofstream json(job.profilePrefix + ".json");
+        std::ofstream csv(job.profilePrefix + ".csv");
+        std::ofstream flat(job.profilePrefix + ".flat.txt");
+        chip8.profile.writeJson(json);
+        chip8.profile.writeCsv(csv);
+        chip8.profile.writeFlat(flat, chip8);
+        if(!json || !csv || !flat) {
+            result.error = "can not write the profile";
+            return result;
+        }
+    }
+#endif
+    if(log.hasExpected) {
+        result.replayChecked = true;
+        result.replayMatched = result.registersHash == log.registersHash &&
+                               result.memoryHash == log.memoryHash &&
+                               result.displayHash == log.displayHash;
+    }
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.instructionsPerSecond = result.seconds > 0 ? result.cycles / result.seconds : 0;
+    return result;
+}
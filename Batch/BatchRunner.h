@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Chip8.h"
+#include "InputLog.h"
+#include "RomLibrary.h"
+#include "WorkStealingPool.h"
+
+/**
+ * One headless run: a ROM, how many instructions to execute
+ * and an optional input script
+ */
+struct BatchJob {
+    std::string romPath;
+    std::uint64_t cycleBudget{};
+
+    //emulated instructions per second, the timers tick once per 1/60 of it
+    double frequency{500};
+
+    //seeds CXNN so runs are reproducible
+    std::uint64_t seed{};
+
+    //replaces the quirk profile the ROM library has for the ROM
+    bool hasQuirks{false};
+    QuirkProfile quirks{QuirkProfile::Default};
+
+    //path to an input script or a recorded InputLog. Its seed, frequency and quirks replace the ones above,
+    //a recorded end replaces the cycle budget and recorded hashes are checked against the result
+    std::string inputScript;
+
+    Chip8::Engine engine{Chip8::Engine::Interpreter};
+
+    //fast-forward idle loops, off to measure raw instruction throughput
+    bool idleSkipping{true};
+
+    //profiling builds write <profilePrefix>.json, .csv and .flat.txt when set
+    std::string profilePrefix;
+
+    //render the sound into this WAV file when set
+    std::string wavPath;
+
+    //run on the dynamic recompiler instead of the engine above
+    bool jit{false};
+    //check every JIT block against the interpreter
+    bool verifyJit{false};
+};
+
+struct BatchResult {
+    std::string romPath;
+    bool ok{false};
+    std::string error;
+
+    QuirkProfile quirks{QuirkProfile::Default};
+
+    std::uint64_t cycles{};
+    std::uint64_t registersHash{};
+    std::uint64_t memoryHash{};
+    std::uint64_t displayHash{};
+
+    //instructions fast-forwarded in idle loops instead of executed
+    std::uint64_t idleCycles{};
+
+    //JIT blocks that did not match the interpreter, only counted with verifyJit
+    std::uint64_t jitMismatches{};
+
+    //set when the input log had expected hashes
+    bool replayChecked{false};
+    bool replayMatched{false};
+
+    double seconds{};
+    double instructionsPerSecond{};
+};
+
+/**
+ * Runs many Chip8 instances unthrottled across all cores
+ */
+class BatchRunner {
+    private:
+        WorkStealingPool pool;
+        //every ROM is read once however many jobs run it
+        RomLibrary library;
+
+    public:
+        explicit BatchRunner(unsigned threads = std::thread::hardware_concurrency());
+
+        unsigned threadCount() const;
+
+        //where the jobs' ROMs are loaded from, e.g. to add quirk metadata before run()
+        RomLibrary& romLibrary();
+
+        /**
+         * Run every job, results are returned in job order
+         */
+        std::vector<BatchResult> run(const std::vector<BatchJob>& jobs);
+
+        /**
+         * Run a single job on the calling thread
+         * @param library: Where the ROM is loaded from
+         */
+        static BatchResult runJob(const BatchJob& job, RomLibrary& library);
+};
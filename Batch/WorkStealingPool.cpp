@@ -0,0 +1,112 @@
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount) {
+    if(threadCount == 0) threadCount = 1;
+
+    for(unsigned i = 0; i < threadCount; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    //worker 0 is the thread calling parallelFor
+    for(unsigned i = 1; i < threadCount; i++) {
+        threads.emplace_back(&WorkStealingPool::threadLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for(auto& thread : threads) {
+        thread.join();
+    }
+}
+
+unsigned WorkStealingPool::size() const {
+    return workers.size();
+}
+
+void WorkStealingPool::threadLoop(unsigned worker) {
+    std::uint64_t seenGeneration = 0;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if(stopping) return;
+            seenGeneration = generation;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if(--busyThreads == 0) finished.notify_all();
+    }
+}
+
+bool WorkStealingPool::popWork(unsigned worker, Range& range) {
+    //own queue first, newest work is the hottest in cache
+    {
+        Worker& own = *workers[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if(!own.queue.empty()) {
+            range = own.queue.back();
+            own.queue.pop_back();
+            return true;
+        }
+    }
+
+    //steal the oldest work of another worker
+    for(unsigned i = 1; i < workers.size(); i++) {
+        Worker& victim = *workers[(worker + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!victim.queue.empty()) {
+            range = victim.queue.front();
+            victim.queue.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::drain(unsigned worker) {
+    Range range{};
+    while(popWork(worker, range)) {
+        for(std::size_t i = range.begin; i < range.end; i++) {
+            (*task)(i, worker);
+        }
+    }
+}
+
+void WorkStealingPool::parallelFor(
+        std::size_t count,
+        const std::function<void(std::size_t, unsigned)>& fn,
+        std::size_t grain
+) {
+    if(count == 0) return;
+    if(grain == 0) grain = 1;
+
+    //deal the ranges out round-robin, stealing evens out the rest
+    unsigned next = 0;
+    for(std::size_t begin = 0; begin < count; begin += grain) {
+        Worker& w = *workers[next];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.queue.push_back({begin, std::min(count, begin + grain)});
+        next = (next + 1) % workers.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        busyThreads = threads.size();
+        ++generation;
+    }
+    wakeUp.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return busyThreads == 0; });
+    task = nullptr;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads with one deque per worker.
+ * A worker pops work from the back of its own deque and,
+ * once that runs dry, steals from the front of the others,
+ * so long-running ROMs do not leave the rest of the cores idle
+ */
+class WorkStealingPool {
+    private:
+        struct Range {
+            std::size_t begin;
+            std::size_t end;
+        };
+
+        struct Worker {
+            std::mutex mutex;
+            std::deque<Range> queue;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        std::condition_variable finished;
+        std::uint64_t generation{};
+        unsigned busyThreads{};
+        bool stopping{false};
+
+        const std::function<void(std::size_t, unsigned)>* task{nullptr};
+
+        void threadLoop(unsigned worker);
+        bool popWork(unsigned worker, Range& range);
+        void drain(unsigned worker);
+
+    public:
+        /**
+         * @param threadCount: Total number of workers, including the calling thread
+         */
+        explicit WorkStealingPool(unsigned threadCount = std::thread::hardware_concurrency());
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        unsigned size() const;
+
+        /**
+         * Run fn(index, worker) for every index in [0, count) and block until all of them finished
+         * @param grain: Number of consecutive indices handed out as one unit of work
+         */
+        void parallelFor(
+                std::size_t count,
+                const std::function<void(std::size_t, unsigned)>& fn,
+                std::size_t grain = 1
+        );
+};
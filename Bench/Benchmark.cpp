@@ -0,0 +1,70 @@
+#include "Benchmark.h"
+
+#include <chrono>
+#include <cstdio>
+
+BenchmarkSuite::BenchmarkSuite(double minSeconds, unsigned repetitions, const std::string& filter)
+        : minSeconds(minSeconds), repetitions(repetitions > 0 ? repetitions : 1), filter(filter) {}
+
+void BenchmarkSuite::run(const std::string& name, const std::function<void(std::uint64_t)>& body) {
+    if(!filter.empty() && name.find(filter) == std::string::npos) return;
+
+    typedef std::chrono::steady_clock Clock;
+    auto measure = [&](std::uint64_t iterations) {
+        auto start = Clock::now();
+        body(iterations);
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    //also warms up caches, branch predictors and the JIT
+    std::uint64_t iterations = 1024;
+    double seconds = measure(iterations);
+    while(seconds < minSeconds && iterations < (1ull << 40)) {
+        iterations *= 2;
+        seconds = measure(iterations);
+    }
+
+    for(unsigned i = 1; i < repetitions; i++) {
+        double repeated = measure(iterations);
+        if(repeated < seconds) seconds = repeated;
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerOp = seconds * 1e9 / iterations;
+    result.opsPerSecond = seconds > 0 ? iterations / seconds : 0;
+    results.push_back(result);
+
+    std::fprintf(stderr, "%-36s %10.2f ns/op %14.0f ops/s\n", name.c_str(), result.nsPerOp, result.opsPerSecond);
+}
+
+const std::vector<BenchmarkResult>& BenchmarkSuite::getResults() const {
+    return results;
+}
+
+void BenchmarkSuite::writeJson(std::ostream& out) const {
+    char line[256];
+    out << "{\n  \"benchmarks\": [\n";
+    for(std::size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& result = results[i];
+        //names are built from fixed identifiers, nothing needs escaping
+        std::snprintf(line, sizeof(line),
+                      "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.4f, \"ops_per_second\": %.1f}%s\n",
+                      result.name.c_str(), (unsigned long long)result.iterations,
+                      result.nsPerOp, result.opsPerSecond, i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ]\n}\n";
+}
+
+void BenchmarkSuite::writeCsv(std::ostream& out) const {
+    char line[256];
+    out << "name,iterations,ns_per_op,ops_per_second\n";
+    for(const BenchmarkResult& result : results) {
+        std::snprintf(line, sizeof(line), "%s,%llu,%.4f,%.1f\n",
+                      result.name.c_str(), (unsigned long long)result.iterations,
+                      result.nsPerOp, result.opsPerSecond);
+        out << line;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct BenchmarkResult {
+    std::string name;
+    //operations of the fastest repetition
+    std::uint64_t iterations{};
+    double nsPerOp{};
+    double opsPerSecond{};
+};
+
+/**
+ * Minimal timing harness: every benchmark is a body that performs a given number
+ * of operations. The count is doubled until one call takes minSeconds,
+ * then the best of a few repetitions is kept, which filters out scheduler noise
+ */
+class BenchmarkSuite {
+    private:
+        double minSeconds;
+        unsigned repetitions;
+        std::string filter;
+        std::vector<BenchmarkResult> results;
+
+    public:
+        /**
+         * @param filter: Only benchmarks whose name contains it are run, empty runs all
+         */
+        BenchmarkSuite(double minSeconds, unsigned repetitions, const std::string& filter);
+
+        /**
+         * @param body: Performs the given number of operations
+         */
+        void run(const std::string& name, const std::function<void(std::uint64_t)>& body);
+
+        const std::vector<BenchmarkResult>& getResults() const;
+
+        /**
+         * {"benchmarks": [{"name", "iterations", "ns_per_op", "ops_per_second"}, ...]}
+         */
+        void writeJson(std::ostream& out) const;
+
+        //name,iterations,ns_per_op,ops_per_second with a header line
+        void writeCsv(std::ostream& out) const;
+};
@@ -0,0 +1,102 @@
+#include "SyntheticRoms.h"
+
+namespace {
+
+    const std::uint8_t ALU_ROM[] = {
+            0x60, 0x13, //200: V0 = 0x13
+            0x61, 0x37, //202: V1 = 0x37
+            0x62, 0x05, //204: V2 = 0x05
+            0x80, 0x14, //206: V0 += V1
+            0x81, 0x05, //208: V1 -= V0
+            0x82, 0x06, //20A: V2 >>= 1
+            0x83, 0x17, //20C: V3 = V1 - V3
+            0x84, 0x0E, //20E: V4 <<= 1
+            0x85, 0x11, //210: V5 |= V1
+            0x86, 0x22, //212: V6 &= V2
+            0x87, 0x33, //214: V7 ^= V3
+            0x70, 0x01, //216: V0 += 1
+            0x12, 0x06  //218: jump 206
+    };
+
+    const std::uint8_t DRAW_ROM[] = {
+            0xA0, 0x50, //200: I = 0x050, the font
+            0xD0, 0x15, //202: draw 5 rows at V0, V1
+            0x70, 0x03, //204: V0 += 3
+            0x71, 0x01, //206: V1 += 1
+            0xD0, 0x1F, //208: draw 15 rows at V0, V1
+            0xF2, 0x29, //20A: I = digit V2
+            0x72, 0x01, //20C: V2 += 1
+            0x12, 0x02  //20E: jump 202
+    };
+
+    const std::uint8_t MEMORY_ROM[] = {
+            0xA4, 0x00, //200: I = 0x400
+            0xF3, 0x33, //202: BCD of V3 at I
+            0xFF, 0x55, //204: store V0..VF at I
+            0xFF, 0x65, //206: load V0..VF from I
+            0x73, 0x07, //208: V3 += 7
+            0x12, 0x00  //20A: jump 200
+    };
+
+    const std::uint8_t BRANCH_ROM[] = {
+            0x60, 0x00, //200: V0 = 0
+            0x70, 0x01, //202: V0 += 1
+            0x30, 0x80, //204: skip if V0 == 0x80
+            0x22, 0x10, //206: call 210
+            0x40, 0x00, //208: skip if V0 != 0
+            0x61, 0x01, //20A: V1 = 1
+            0x12, 0x02, //20C: jump 202
+            0x00, 0x00, //20E: padding
+            0x50, 0x10, //210: skip if V0 == V1
+            0x71, 0x01, //212: V1 += 1
+            0x00, 0xEE  //214: return
+    };
+
+    const std::uint8_t DIVERGE_ROM[] = {
+            0xC0, 0x01, //200: V0 = random bit
+            0x30, 0x00, //202: skip if V0 == 0
+            0x71, 0x01, //204: V1 += 1
+            0x72, 0x01, //206: V2 += 1
+            0x80, 0x24, //208: V0 += V2
+            0x12, 0x00  //20A: jump 200
+    };
+
+    const std::uint8_t SELFMOD_ROM[] = {
+            0x61, 0xFF, //200: V1 = 0xFF
+            0xC0, 0xFF, //202: V0 = random byte
+            0xA2, 0x39, //204: I = 0x239
+            0xF1, 0x1E, //206: I += V1, 16 times to 0x1229
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF1, 0x1E,
+            0xF0, 0x55, //226: store V0 at I, which wraps to 0x229
+            0x62, 0x00, //228: V2 = the stored byte
+            0x84, 0x24, //22A: V4 += V2
+            0x12, 0x02  //22C: jump 202
+    };
+
+}
+
+const std::vector<SyntheticRom>& SyntheticRoms::all() {
+    static const std::vector<SyntheticRom> roms = {
+            {"alu", ALU_ROM, sizeof(ALU_ROM)},
+            {"draw", DRAW_ROM, sizeof(DRAW_ROM)},
+            {"memory", MEMORY_ROM, sizeof(MEMORY_ROM)},
+            {"branch", BRANCH_ROM, sizeof(BRANCH_ROM)},
+            {"diverge", DIVERGE_ROM, sizeof(DIVERGE_ROM)},
+            {"selfmod", SELFMOD_ROM, sizeof(SELFMOD_ROM)}
+    };
+    return roms;
+}
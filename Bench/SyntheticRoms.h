@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * A ROM built into the benchmark, loops forever and never waits for input or timers
+ */
+struct SyntheticRom {
+    const char* name;
+    const std::uint8_t* data;
+    std::size_t size;
+};
+
+struct SyntheticRoms {
+    SyntheticRoms() = delete;
+
+    /**
+     * alu: 8XY1..8XYE and 7XNN in a tight loop
+     * draw: DXYN of 5 and 15 rows at moving positions, FX29
+     * memory: FX33, FX55 and FX65 of all 16 registers
+     * branch: 3XNN/4XNN/5XY0 skips, 2NNN/00EE calls
+     * diverge: a skip on a random bit, instances with different seeds split and rejoin
+     * selfmod: FX55 through an I past 0xFFF rewrites the operand of the next instruction with a random byte
+     */
+    static const std::vector<SyntheticRom>& all();
+};
@@ -1,146 +1,678 @@
 #include "Chip8.h"
 
-Chip8::Chip8() : randomEngine(time(NULL)) {
-
-    //setting the uniform int distribution
-    randByte = std::uniform_int_distribution<std::uint8_t>(0,255U);
-    pc = start_address;
-    keyPad.fill(false);
-    for(ll i = 0; i < fontset_size; i++) {
-        memory[fontset_start_address + i] = fontSet[i];
-    }
-
-    //filling the instruction table
-    instructionTable[0x0] = &Chip8::Table0;
-    instructionTable[0x1] = &Chip8::OP_1NNN;
-    instructionTable[0x2] = &Chip8::OP_2NNN;
-    instructionTable[0x3] = &Chip8::OP_3XNN;
-    instructionTable[0x4] = &Chip8::OP_4XNN;
-    instructionTable[0x5] = &Chip8::OP_5XY0;
-    instructionTable[0x6] = &Chip8::OP_6XNN;
-    instructionTable[0x7] = &Chip8::OP_7XNN;
-    instructionTable[0x8] = &Chip8::Table8;
-    instructionTable[0x9] = &Chip8::OP_9XY0;
-    instructionTable[0xA] = &Chip8::OP_ANNN;
-    instructionTable[0xB] = &Chip8::OP_BNNN;
-    instructionTable[0xC] = &Chip8::OP_CXNN;
-    instructionTable[0xD] = &Chip8::OP_DXYN;
-    instructionTable[0xE] = &Chip8::TableE;
-    instructionTable[0xF] = &Chip8::TableF;
-
-    for(std::uint8_t i = 0; i < 0x65 + 1; i++) {
-        if(i < 0xE + 1) {
-            table0[i] = &Chip8::OP_NULL;
-            table8[i] = &Chip8::OP_NULL;
-            tableE[i] = &Chip8::OP_NULL;
-        }
-        tableF[i] = &Chip8::OP_NULL;
+#include <bitset>
+#include <cstring>
+
+template<typename Quirks>
+constexpr Chip8::Chip8Func Chip8::handlerFor(Op op) {
+    switch(op) {
+        case Op::OP_00E0: return &Chip8::OP_00E0;
+        case Op::OP_00EE: return &Chip8::OP_00EE;
+        case Op::OP_1NNN: return &Chip8::OP_1NNN;
+        case Op::OP_2NNN: return &Chip8::OP_2NNN;
+        case Op::OP_3XNN: return &Chip8::OP_3XNN<Quirks>;
+        case Op::OP_4XNN: return &Chip8::OP_4XNN<Quirks>;
+        case Op::OP_5XY0: return &Chip8::OP_5XY0<Quirks>;
+        case Op::OP_6XNN: return &Chip8::OP_6XNN;
+        case Op::OP_7XNN: return &Chip8::OP_7XNN;
+        case Op::OP_8XY0: return &Chip8::OP_8XY0;
+        case Op::OP_8XY1: return &Chip8::OP_8XY1<Quirks>;
+        case Op::OP_8XY2: return &Chip8::OP_8XY2<Quirks>;
+        case Op::OP_8XY3: return &Chip8::OP_8XY3<Quirks>;
+        case Op::OP_8XY4: return &Chip8::OP_8XY4;
+        case Op::OP_8XY5: return &Chip8::OP_8XY5;
+        case Op::OP_8XY6: return &Chip8::OP_8XY6<Quirks>;
+        case Op::OP_8XY7: return &Chip8::OP_8XY7;
+        case Op::OP_8XYE: return &Chip8::OP_8XYE<Quirks>;
+        case Op::OP_9XY0: return &Chip8::OP_9XY0<Quirks>;
+        case Op::OP_ANNN: return &Chip8::OP_ANNN;
+        case Op::OP_BNNN: return &Chip8::OP_BNNN<Quirks>;
+        case Op::OP_CXNN: return &Chip8::OP_CXNN;
+        case Op::OP_DXYN: return &Chip8::OP_DXYN<Quirks>;
+        case Op::OP_EX9E: return &Chip8::OP_EX9E<Quirks>;
+        case Op::OP_EXA1: return &Chip8::OP_EXA1<Quirks>;
+        case Op::OP_FX07: return &Chip8::OP_FX07;
+        case Op::OP_FX0A: return &Chip8::OP_FX0A;
+        case Op::OP_FX15: return &Chip8::OP_FX15;
+        case Op::OP_FX18: return &Chip8::OP_FX18;
+        case Op::OP_FX1E: return &Chip8::OP_FX1E;
+        case Op::OP_FX29: return &Chip8::OP_FX29;
+        case Op::OP_FX33: return &Chip8::OP_FX33<Quirks>;
+        case Op::OP_FX55: return &Chip8::OP_FX55<Quirks>;
+        case Op::OP_FX65: return &Chip8::OP_FX65<Quirks>;
+        case Op::OP_00CN: return &Chip8::OP_00CN;
+        case Op::OP_00DN: return &Chip8::OP_00DN;
+        case Op::OP_00FB: return &Chip8::OP_00FB;
+        case Op::OP_00FC: return &Chip8::OP_00FC;
+        case Op::OP_00FD: return &Chip8::OP_00FD;
+        case Op::OP_00FE: return &Chip8::OP_00FE;
+        case Op::OP_00FF: return &Chip8::OP_00FF;
+        case Op::OP_5XY2: return &Chip8::OP_5XY2<Quirks>;
+        case Op::OP_5XY3: return &Chip8::OP_5XY3<Quirks>;
+        case Op::OP_F000: return &Chip8::OP_F000;
+        case Op::OP_FN01: return &Chip8::OP_FN01;
+        case Op::OP_F002: return &Chip8::OP_F002<Quirks>;
+        case Op::OP_FX30: return &Chip8::OP_FX30;
+        case Op::OP_FX3A: return &Chip8::OP_FX3A;
+        case Op::OP_FX75: return &Chip8::OP_FX75;
+        case Op::OP_FX85: return &Chip8::OP_FX85;
+        default: return &Chip8::OP_NULL;
     }
+}
 
-    //table0 - instructions starting with a zero
-    table0[0x0] = &Chip8::OP_00E0;
-    table0[0xe] = &Chip8::OP_00EE;
+template<typename Quirks>
+constexpr Chip8::DispatchTables Chip8::makeDispatchTables() {
+    DispatchTables tables{};
+    //every entry is the handler of a representative opcode, decoded exactly like OP_TABLE
+    for(std::uint16_t i = 0; i < tables.main.size(); i++) {
+        tables.main[i] = handlerFor<Quirks>(decodeOp(i << 12u, Quirks::extended));
+    }
+    tables.main[0x0] = &Chip8::Table0<Quirks>;
+    tables.main[0x5] = &Chip8::Table5<Quirks>;
+    tables.main[0x8] = &Chip8::Table8<Quirks>;
+    tables.main[0xE] = &Chip8::TableE<Quirks>;
+    tables.main[0xF] = &Chip8::TableF<Quirks>;
+
+    for(std::uint16_t i = 0; i < tables.table0.size(); i++) {
+        tables.table0[i] = handlerFor<Quirks>(decodeOp(i, Quirks::extended));
+    }
+    for(std::uint16_t i = 0; i < tables.table5.size(); i++) {
+        tables.table5[i] = handlerFor<Quirks>(decodeOp(0x5000u | i, Quirks::extended));
+    }
+    for(std::uint16_t i = 0; i < tables.table8.size(); i++) {
+        tables.table8[i] = handlerFor<Quirks>(decodeOp(0x8000u | i, Quirks::extended));
+        tables.tableE[i] = handlerFor<Quirks>(decodeOp(0xE000u | i, Quirks::extended));
+    }
+    for(std::uint16_t i = 0; i < tables.tableF.size(); i++) {
+        tables.tableF[i] = handlerFor<Quirks>(decodeOp(0xF000u | i, Quirks::extended));
+    }
+    return tables;
+}
 
-    //table8 - instructions starting with a eight
-    table8[0x0] = &Chip8::OP_8XY0;
-    table8[0x1] = &Chip8::OP_8XY1;
-    table8[0x2] = &Chip8::OP_8XY2;
-    table8[0x3] = &Chip8::OP_8XY3;
-    table8[0x4] = &Chip8::OP_8XY4;
-    table8[0x5] = &Chip8::OP_8XY5;
-    table8[0x6] = &Chip8::OP_8XY6;
-    table8[0x7] = &Chip8::OP_8XY7;
-    table8[0xE] = &Chip8::OP_8XYE;
+//the dispatch tables of every quirk profile, in read-only data instead of in every instance
+template<typename Quirks>
+static constexpr Chip8::DispatchTables DISPATCH_TABLES = Chip8::makeDispatchTables<Quirks>();
 
-    //tableE - instructions starting with E
-    tableE[0x1] = &Chip8::OP_EXA1;
-    tableE[0xE] = &Chip8::OP_EX9E;
+static_assert(Profile::ADDRESSES == Chip8::MEMORY_SIZE, "the profile counts every address a pc can hold");
 
-    //table F - instructions starting with F
-    tableF[0x07] = &Chip8::OP_FX07;
-    tableF[0x0A] = &Chip8::OP_FX0A;
-    tableF[0x15] = &Chip8::OP_FX15;
-    tableF[0x18] = &Chip8::OP_FX18;
-    tableF[0x1E] = &Chip8::OP_FX1E;
-    tableF[0x29] = &Chip8::OP_FX29;
-    tableF[0x33] = &Chip8::OP_FX33;
-    tableF[0x55] = &Chip8::OP_FX55;
-    tableF[0x65] = &Chip8::OP_FX65;
+Chip8::Chip8() : Chip8(std::uint64_t(time(NULL))) {}
 
+Chip8::Chip8(std::uint64_t seed)
+        : tables(&DISPATCH_TABLES<DefaultQuirks>), randomEngine(seed), memory(addressableMemory(QuirkProfile::Default)) {
+    pc = start_address;
+    std::copy(fontSet.begin(), fontSet.end(), memory.begin() + fontset_start_address);
 }
 
+template<typename Quirks>
 void Chip8::Table0() {
+    std::uint8_t index = opcode & 0x00FFu;
+    auto f = DISPATCH_TABLES<Quirks>.table0[index];
+    (this->*f)();
+}
+
+template<typename Quirks>
+void Chip8::Table5() {
     std::uint8_t index = opcode & 0x000Fu;
-    auto f = table0[index];
+    auto f = DISPATCH_TABLES<Quirks>.table5[index];
     (this->*f)();
 }
 
+template<typename Quirks>
 void Chip8::Table8() {
     std::uint8_t index = opcode & 0x000Fu;
-    auto f = table8[index];
+    auto f = DISPATCH_TABLES<Quirks>.table8[index];
     (this->*f)();
 }
 
+template<typename Quirks>
 void Chip8::TableE() {
     std::uint8_t index = opcode & 0x000Fu;
-    auto f = tableE[index];
+    auto f = DISPATCH_TABLES<Quirks>.tableE[index];
     (this->*f)();
 }
 
+template<typename Quirks>
 void Chip8::TableF() {
     std::uint8_t index = opcode & 0x00FFu;
-    auto f = tableF[index];
+    //FX86 and up are not instructions, same as in decode()
+    if(index >= DISPATCH_TABLES<Quirks>.tableF.size()) return;
+    auto f = DISPATCH_TABLES<Quirks>.tableF[index];
     (this->*f)();
 }
 
+/**
+ * Calls visit(pointer, size) for every field of a save state but memory, in file order.
+ * Shared by saving and loading so the two can never disagree on the layout
+ */
+template<typename Self, typename Visitor>
+static void visitCoreState(Self& chip8, Visitor&& visit) {
+    visit(chip8.registers.data(), sizeof(chip8.registers));
+    visit(&chip8.vi, sizeof(chip8.vi));
+    visit(&chip8.pc, sizeof(chip8.pc));
+    visit(chip8.stack.data(), sizeof(chip8.stack));
+    visit(&chip8.sp, sizeof(chip8.sp));
+    visit(&chip8.delay_timer, sizeof(chip8.delay_timer));
+    visit(&chip8.sound_timer, sizeof(chip8.sound_timer));
+    visit(&chip8.cycleCount, sizeof(chip8.cycleCount));
+    visit(&chip8.opcode, sizeof(chip8.opcode));
+    visit(&chip8.program_size, sizeof(chip8.program_size));
+    visit(&chip8.romLoaded, sizeof(chip8.romLoaded));
+    visit(chip8.keyPad.data(), sizeof(chip8.keyPad));
+    visit(&chip8.randomEngine.state, sizeof(chip8.randomEngine.state));
+    visit(chip8.display.planes.data(), sizeof(chip8.display.planes));
+    visit(&chip8.display.hires, sizeof(chip8.display.hires));
+    visit(&chip8.planeMask, sizeof(chip8.planeMask));
+    visit(chip8.flags.data(), sizeof(chip8.flags));
+    visit(chip8.audioPattern.data(), sizeof(chip8.audioPattern));
+    visit(&chip8.pitch, sizeof(chip8.pitch));
+}
+
+std::size_t Chip8::stateSize() {
+    //memory is stored as the whole address space whatever the profile has, the states of all profiles are alike
+    return STATE_HEADER_SIZE + coreStateSize() + MEMORY_SIZE;
+}
+
+std::size_t Chip8::saveState(std::uint8_t* buffer, std::size_t size) const {
+    std::size_t total = stateSize();
+    if(size < total) return 0;
+
+    std::uint32_t magic = STATE_MAGIC;
+    std::uint16_t version = STATE_VERSION;
+    std::uint16_t reserved = 0;
+    std::uint32_t payload = total - STATE_HEADER_SIZE;
+    std::memcpy(buffer, &magic, 4);
+    std::memcpy(buffer + 4, &version, 2);
+    std::memcpy(buffer + 6, &reserved, 2);
+    std::memcpy(buffer + 8, &payload, 4);
+
+    std::uint8_t* out = buffer + STATE_HEADER_SIZE;
+    saveCoreState(out);
+    out += coreStateSize();
+    std::memcpy(out, memory.data(), memory.size());
+    std::fill(out + memory.size(), out + MEMORY_SIZE, 0);
+    return total;
+}
+
+std::vector<std::uint8_t> Chip8::saveState() const {
+    std::vector<std::uint8_t> buffer(stateSize());
+    saveState(buffer.data(), buffer.size());
+    return buffer;
+}
+
+bool Chip8::loadState(const std::uint8_t* buffer, std::size_t size) {
+    std::size_t total = stateSize();
+    if(size < total) return false;
+
+    std::uint32_t magic;
+    std::uint16_t version;
+    std::uint32_t payload;
+    std::memcpy(&magic, buffer, 4);
+    std::memcpy(&version, buffer + 4, 2);
+    std::memcpy(&payload, buffer + 8, 4);
+    if(magic != STATE_MAGIC || version != STATE_VERSION || payload != total - STATE_HEADER_SIZE) return false;
+
+    const std::uint8_t* in = buffer + STATE_HEADER_SIZE;
+    //bumps displayGeneration, the display has changed
+    loadCoreState(in);
+    in += coreStateSize();
+    //what lies above the memory of the selected profile is out of its reach
+    std::memcpy(memory.data(), in, memory.size());
+
+    //everything in memory may be new code
+    invalidateCode(0, memory.size());
+    return true;
+}
+
+std::size_t Chip8::coreStateSize() {
+    static const std::size_t size = [] {
+        std::size_t total = 0;
+        const Chip8 layout;
+        visitCoreState(layout, [&](const void*, std::size_t fieldSize) { total += fieldSize; });
+        return total;
+    }();
+    return size;
+}
+
+void Chip8::saveCoreState(std::uint8_t* buffer) const {
+    visitCoreState(*this, [&](const void* field, std::size_t fieldSize) {
+        std::memcpy(buffer, field, fieldSize);
+        buffer += fieldSize;
+    });
+}
+
+void Chip8::loadCoreState(const std::uint8_t* buffer) {
+    visitCoreState(*this, [&](void* field, std::size_t fieldSize) {
+        std::memcpy(field, buffer, fieldSize);
+        buffer += fieldSize;
+    });
+    ++displayGeneration;
+}
+
+std::uint64_t Chip8::registersHash() const {
+    std::uint64_t hash = fnv1a(registers.data(), registers.size());
+    hash = fnv1a(&vi, sizeof(vi), hash);
+    hash = fnv1a(&pc, sizeof(pc), hash);
+    hash = fnv1a(stack.data(), sizeof(stack), hash);
+    hash = fnv1a(&sp, sizeof(sp), hash);
+    hash = fnv1a(&delay_timer, sizeof(delay_timer), hash);
+    return fnv1a(&sound_timer, sizeof(sound_timer), hash);
+}
+
+std::uint64_t Chip8::memoryHash() const {
+    return fnv1a(memory.data(), memory.size());
+}
+
+std::uint64_t Chip8::displayHash() const {
+    return display.hash();
+}
+
+Chip8::Operands Chip8::splitOperands(std::uint16_t opcode) {
+    Operands operands{};
+    operands.x = (opcode & 0x0F00u) >> 8u;
+    operands.y = (opcode & 0x00F0u) >> 4u;
+    operands.n = opcode & 0x000Fu;
+    operands.nn = opcode & 0x00FFu;
+    operands.nnn = opcode & 0x0FFFu;
+    return operands;
+}
+
+Chip8::DecodedOp Chip8::decode(std::uint16_t opcode) const {
+    DecodedOp op{};
+    op.opcode = opcode;
+    op.args = splitOperands(opcode);
+
+    //resolve the second level tables here instead of on every execution
+    switch((opcode & 0xF000u) >> 12u) {
+        case 0x0: op.handler = tables->table0[opcode & 0x00FFu]; break;
+        case 0x5: op.handler = tables->table5[opcode & 0x000Fu]; break;
+        case 0x8: op.handler = tables->table8[opcode & 0x000Fu]; break;
+        case 0xE: op.handler = tables->tableE[opcode & 0x000Fu]; break;
+        case 0xF: op.handler = (opcode & 0x00FFu) < tables->tableF.size() ? tables->tableF[opcode & 0x00FFu] : &Chip8::OP_NULL; break;
+        default: op.handler = tables->main[(opcode & 0xF000u) >> 12u]; break;
+    }
+    return op;
+}
+
+void Chip8::unpackDisplay(std::uint8_t* out) const {
+    std::size_t width = display.width();
+    for(std::size_t y = 0; y < display.height(); y++) {
+        for(std::size_t x = 0; x < width; x++) {
+            out[y * width + x] = display.pixel(x, y);
+        }
+    }
+}
+
+void Chip8::setEngine(Engine newEngine) {
+    engine = newEngine;
+    if(engine == Engine::DecodeCache) {
+        decodedOps.assign(memory.size(), DecodedOp{});
+    }
+    else {
+        //release the cache, interpreter instances stay small
+        std::vector<DecodedOp>().swap(decodedOps);
+    }
+}
+
+void Chip8::setQuirks(QuirkProfile profile) {
+    quirks = profile;
+    //4 KB for all but XO-CHIP, what lies above the new size is gone and what comes into reach is empty
+    memory.resize(addressableMemory(profile));
+    if(!decodedOps.empty()) {
+        decodedOps.assign(memory.size(), DecodedOp{});
+    }
+    dirtyEnd = std::min<std::uint32_t>(dirtyEnd, memory.size());
+    if(dirtyBegin >= dirtyEnd) {
+        dirtyBegin = 0xFFFF;
+        dirtyEnd = 0;
+    }
+    for(std::size_t page = memory.size() / PAGE_SIZE; page < MEMORY_SIZE / PAGE_SIZE; page++) {
+        writtenPages[page / 64] &= ~(std::uint64_t(1) << (page % 64));
+    }
+    //the large digits only exist where FX30 can point at them
+    for(std::size_t i = 0; i < big_fontset_size; i++) {
+        memory[big_fontset_start_address + i] = extendedInstructions(profile) ? bigFontSet[i] : 0;
+    }
+    switch(profile) {
+        case QuirkProfile::Cosmac: tables = &DISPATCH_TABLES<CosmacQuirks>; break;
+        case QuirkProfile::SuperChip: tables = &DISPATCH_TABLES<SuperChipQuirks>; break;
+        case QuirkProfile::XoChip: tables = &DISPATCH_TABLES<XoChipQuirks>; break;
+        default: tables = &DISPATCH_TABLES<DefaultQuirks>; break;
+    }
+    //cached handlers and JIT blocks were specialized for the previous profile
+    invalidateCode(0, memory.size());
+}
+
+void Chip8::invalidateCode(std::uint16_t address, std::uint32_t length, std::uint16_t addressMask) {
+    //writes through I wrap around the memory the profile reaches, 4 KB on all but XO-CHIP
+    std::uint32_t size = std::uint32_t(addressMask) + 1;
+    address &= addressMask;
+    if(address + length > size) {
+        invalidateCode(0, address + length - size, addressMask);
+        length = size - address;
+    }
+    //nothing lies above the memory of the profile
+    if(address >= memory.size()) return;
+    length = std::min<std::uint32_t>(length, memory.size() - address);
+
+    codeWriteBegin = std::min<std::uint16_t>(codeWriteBegin, address);
+    codeWriteEnd = std::max<std::uint16_t>(codeWriteEnd, std::min<std::uint32_t>(0xFFFF, address + length));
+    dirtyBegin = std::min<std::uint16_t>(dirtyBegin, address);
+    dirtyEnd = std::max<std::uint32_t>(dirtyEnd, address + length);
+    if(length > 0) {
+        for(std::size_t page = address / PAGE_SIZE; page <= (address + length - 1) / PAGE_SIZE; page++) {
+            writtenPages[page / 64] |= std::uint64_t(1) << (page % 64);
+        }
+    }
+
+    if(decodedOps.empty()) return;
+
+    //an instruction starting one byte earlier also covers the first written byte
+    std::size_t first = address > 0 ? address - 1 : 0;
+    std::size_t last = std::min<std::size_t>(decodedOps.size(), std::size_t(address) + length);
+    for(std::size_t i = first; i < last; i++) {
+        decodedOps[i].handler = nullptr;
+    }
+}
+
+void Chip8::clearCodeWrites() {
+    codeWriteBegin = 0xFFFF;
+    codeWriteEnd = 0;
+}
+
+void Chip8::clearWrittenPages() {
+    writtenPages.fill(0);
+}
+
 void Chip8::cycle() {
-    opcode = (memory[pc] << 8u) | memory[pc+1];
-    //increment the program counter before execution
-    pc += 2;
+    if(engine == Engine::Threaded) {
+        run(1);
+        return;
+    }
 
-    //process the opcode
-    executeInstruction();
+    //a pc above the memory of the profile has nothing to cache, it fetches zeros
+    if(engine == Engine::DecodeCache && pc < decodedOps.size()) {
+        DecodedOp& op = decodedOps[pc];
+        if(op.handler == nullptr) {
+            op = decode(fetch(pc));
+        }
+        opcode = op.opcode;
+        args = op.args;
+        CHIP8_PROFILE_HOOK(profile.countInstruction(pc, opOf(opcode)));
+        pc += 2;
+        ++cycleCount;
+        (this->*op.handler)();
+    }
+    else {
+        opcode = fetch(pc);
+        CHIP8_PROFILE_HOOK(profile.countInstruction(pc, opOf(opcode)));
+        //increment the program counter before execution
+        pc += 2;
+        ++cycleCount;
 
+        //process the opcode
+        executeInstruction();
+    }
+}
+
+void Chip8::tickTimers() {
     //decrementing the delay timer and sound timer
     if(delay_timer > 0) --delay_timer;
     if(sound_timer > 0) --sound_timer;
 }
 
+void Chip8::run(std::uint64_t cycles) {
+    if(engine != Engine::Threaded) {
+        while(cycles > 0) {
+            cycle();
+            --cycles;
+            //only a jump or a key wait can close an idle loop
+            if((opcode & 0xF000u) == 0x1000u || (opcode & 0xF0FFu) == 0xF00Au) {
+                std::uint64_t before = cycles;
+                if(skipIdle(cycles)) cycleCount += before - cycles;
+            }
+        }
+        return;
+    }
+    if(cycles == 0) return;
+    //every path below executes exactly the requested number of instructions
+    cycleCount += cycles;
+
+    //the only quirk check, once per call instead of once per instruction
+    switch(quirks) {
+        case QuirkProfile::Cosmac: runThreaded<CosmacQuirks>(cycles); break;
+        case QuirkProfile::SuperChip: runThreaded<SuperChipQuirks>(cycles); break;
+        case QuirkProfile::XoChip: runThreaded<XoChipQuirks>(cycles); break;
+        default: runThreaded<DefaultQuirks>(cycles); break;
+    }
+}
+
+template<typename Quirks>
+void Chip8::runThreaded(std::uint64_t cycles) {
+    //the profile's own instruction set, fixed at compile time
+    const std::array<Op, 0x1000>& opTable = Quirks::extended ? EXTENDED_OP_TABLE : OP_TABLE;
+
+#if defined(__GNUC__)
+    //direct threaded code: every handler ends with its own indirect jump,
+    //so the branch predictor learns which instruction tends to follow which
+#define CHIP8_OP_LABEL(name) &&label_##name,
+    static const void* const labels[] = { CHIP8_OPS(CHIP8_OP_LABEL) };
+#undef CHIP8_OP_LABEL
+
+#define DISPATCH() \
+    opcode = fetch(pc); \
+    CHIP8_PROFILE_HOOK(profile.countInstruction(pc, opTable[opTableIndex(opcode)]);) \
+    pc += 2; \
+    args = splitOperands(opcode); \
+    goto *labels[static_cast<std::size_t>(opTable[opTableIndex(opcode)])]
+
+//the handler and the idle check are compile time constants, the call is inlined
+//and only the 1NNN and FX0A handlers pay for the check
+#define CHIP8_OP_CASE(name) \
+    label_##name: { \
+        constexpr Chip8Func handler = handlerFor<Quirks>(Op::name); \
+        (this->*handler)(); \
+        if(--cycles == 0) return; \
+        if((Op::name == Op::OP_1NNN || Op::name == Op::OP_FX0A) && skipIdle(cycles) && cycles == 0) return; \
+        DISPATCH(); \
+    }
+
+    DISPATCH();
+    CHIP8_OPS(CHIP8_OP_CASE)
+#undef CHIP8_OP_CASE
+#undef DISPATCH
+#else
+#define CHIP8_OP_CASE(name) \
+    case Op::name: { \
+        constexpr Chip8Func handler = handlerFor<Quirks>(Op::name); \
+        (this->*handler)(); \
+        break; \
+    }
+    while(cycles > 0) {
+        opcode = fetch(pc);
+        Op op = opTable[opTableIndex(opcode)];
+        CHIP8_PROFILE_HOOK(profile.countInstruction(pc, op));
+        pc += 2;
+        args = splitOperands(opcode);
+        switch(op) {
+            CHIP8_OPS(CHIP8_OP_CASE)
+            default: break;
+        }
+        --cycles;
+        if(op == Op::OP_1NNN || op == Op::OP_FX0A) skipIdle(cycles);
+    }
+#undef CHIP8_OP_CASE
+#endif
+}
+
+std::uint8_t Chip8::idleLoopLength() const {
+    //fetched like cycle() does, wrapping around the end of memory
+    auto word = [&](std::uint16_t address) {
+        return fetch(address);
+    };
+    //1NNN only reaches the first 4 KB, above it no jump can target pc
+    bool reachable = pc <= 0x0FFFu;
+
+    std::uint16_t first = word(pc);
+
+    //1NNN jumping to itself
+    if(reachable && first == (0x1000u | pc)) return 1;
+
+    //FX0A with no key down, rewinds pc every cycle
+    if((first & 0xF0FFu) == 0xF00Au) {
+        return std::find(keyPad.begin(), keyPad.end(), true) == keyPad.end() ? 1 : 0;
+    }
+
+    //FX07, 3XNN, 1NNN back to the FX07: spins until the delay timer reaches NN
+    if((first & 0xF0FFu) == 0xF007u) {
+        std::uint16_t second = word(pc + 2);
+        std::uint16_t third = word(pc + 4);
+        if(reachable && (second & 0xFF00u) == (0x3000u | (first & 0x0F00u)) &&
+           third == (0x1000u | pc) &&
+           delay_timer != (second & 0x00FFu)) {
+            return 3;
+        }
+    }
+    return 0;
+}
+
+bool Chip8::skipIdle(std::uint64_t& remaining) {
+    if(!idleSkipping) return false;
+
+    std::uint8_t length = idleLoopLength();
+    if(length == 0) return false;
+
+    //only whole iterations are skipped, the rest of the budget runs normally
+    std::uint64_t skipped = remaining / length * length;
+    if(skipped == 0) return false;
+
+    //leave exactly the state one iteration leaves: the loop's last instruction was executed
+    //and, for the delay spin, VX holds the delay timer, which does not change within a frame
+    std::uint16_t lastAddress = pc + 2 * (length - 1);
+    std::uint16_t last = fetch(lastAddress);
+    if(length == 3) {
+        registers[(fetch(pc) >> 8u) & 0x0Fu] = delay_timer;
+    }
+    opcode = last;
+    args = splitOperands(last);
+
+#ifdef CHIP8_PROFILE
+    //as if every iteration had been executed
+    for(std::uint8_t i = 0; i < length; i++) {
+        std::uint16_t address = pc + 2 * i;
+        std::uint16_t instruction = fetch(address);
+        profile.countInstruction(address, opOf(instruction), skipped / length);
+    }
+    if((last & 0xF0FFu) == 0xF00Au) profile.keyWaitCycles += skipped;
+#endif
+
+    remaining -= skipped;
+    idleCycles += skipped;
+    return true;
+}
+
 void Chip8::executeInstruction() {
+    args = splitOperands(opcode);
     std::uint8_t index = (opcode & 0xF000u) >> 12u;
-    auto f = instructionTable[index];
+    auto f = tables->main[index];
     (this->*f)();
 }
 
-void Chip8::loadRom(const std::string& filePath) {
-    std::ifstream  file(filePath, std::ios::binary | std::ios::ate);
-    if(file.is_open()) {
+std::uint8_t Chip8::loadRom(const std::string& filePath) {
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if(!file.is_open()) {
+        return FailStates::FILE_NOT_FOUND;
+    }
 
-        //tell me the position
-        //of the cursor <=> filesize
-        std::streampos size = file.tellg();
-        program_size = size;
-        char* buffer = new char[size];
+    //tell me the position
+    //of the cursor <=> filesize
+    std::streamoff size = file.tellg();
+    if(size <= 0) return FailStates::ROM_EMPTY;
+    if(static_cast<std::size_t>(size) > maxRomSize()) return FailStates::ROM_TOO_LARGE;
+
+    //go back to the beginning of the file and read it into a buffer of its size, on the heap
+    std::vector<std::uint8_t> buffer(static_cast<std::size_t>(size));
+    file.seekg(0, std::ios::beg);
+    if(!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
+        return FailStates::FILE_NOT_FOUND;
+    }
 
+    return loadRom(buffer.data(), static_cast<std::size_t>(size));
+}
 
-        //go back to the beginning of the file
-        file.seekg(0, std::ios::beg);
+std::uint8_t Chip8::loadRom(const std::uint8_t* data, std::size_t size) {
+    if(size == 0) return FailStates::ROM_EMPTY;
+    if(size > maxRomSize()) return FailStates::ROM_TOO_LARGE;
+
+    std::memcpy(&memory[start_address], data, size);
+    //nothing of a previously loaded ROM is left behind
+    std::fill(memory.begin() + start_address + size, memory.end(), 0);
+    program_size = static_cast<std::uint16_t>(size);
+
+    invalidateCode(start_address, memory.size() - start_address);
+    romImage = std::make_shared<const std::vector<std::uint8_t>>(data, data + size);
+    //everything from start_address on is exactly the image now, only writes below it are left to reset()
+    dirtyEnd = std::min(dirtyEnd, std::uint32_t(start_address));
+    if(dirtyBegin >= dirtyEnd) {
+        dirtyBegin = 0xFFFF;
+        dirtyEnd = 0;
+    }
+    romLoaded = true;
+    return FailStates::SUCCESS;
+}
 
-        file.read(buffer, size);
+std::size_t Chip8::maxRomSize() const {
+    return addressableMemory(quirks) - start_address;
+}
 
-        file.close();
+void Chip8::seedRandom(std::uint64_t seed) {
+    randomEngine.seed(seed);
+}
 
-        for(ll i = 0; i < size; i++) {
-            memory[start_address + i] = buffer[i];
+void Chip8::reset(std::uint64_t seed) {
+    if(dirtyBegin < dirtyEnd) {
+        std::uint16_t begin = dirtyBegin;
+        std::uint32_t end = dirtyEnd;
+        std::fill(memory.begin() + begin, memory.begin() + end, 0);
+        if(begin < start_address) {
+            std::copy(fontSet.begin(), fontSet.end(), memory.begin() + fontset_start_address);
+            if(extendedInstructions(quirks)) {
+                std::copy(bigFontSet.begin(), bigFontSet.end(), memory.begin() + big_fontset_start_address);
+            }
         }
-
-        delete[] buffer;
-        romLoaded = true;
-    }
-    else {
-        std::cout << "ERROR: ROM file not found" << std::endl;
-        exit(FailStates::FILE_NOT_FOUND);
+        if(romImage) {
+            std::uint32_t romEnd = start_address + romImage->size();
+            std::uint32_t first = std::max(std::uint32_t(begin), std::uint32_t(start_address));
+            std::uint32_t last = std::min(end, romEnd);
+            if(first < last) {
+                std::memcpy(&memory[first], romImage->data() + (first - start_address), last - first);
+            }
+        }
+        //drops decoded instructions and tells translators of the restored code
+        invalidateCode(begin, end - begin);
+        dirtyBegin = 0xFFFF;
+        dirtyEnd = 0;
     }
+
+    registers.fill(0);
+    pc = start_address;
+    vi = 0;
+    opcode = 0;
+    args = {};
+    sp = 0;
+    delay_timer = 0;
+    sound_timer = 0;
+    cycleCount = 0;
+    idleCycles = 0;
+    randomEngine.seed(seed);
+    stack.fill(0);
+    keyPad.fill(false);
+    planeMask = 1;
+    pitch = 64;
+    audioPattern.fill(0);
+    flags.fill(0);
+
+    display.setHires(false);
+    ++displayGeneration;
 }
 
 void Chip8::OP_NULL() {
@@ -153,88 +685,99 @@ void Chip8::OP_NULL() {
 //}
 
 void Chip8::OP_00E0() {
-    //simply fill the screen with zeroes
-    display.fill(0);
+    //simply fill the selected planes with zeroes
+    display.clear(planeMask);
+    ++displayGeneration;
 }
 
 void Chip8::OP_00EE() {
     --sp;
-    pc = stack[sp];
+    //sp is not bounded, the index wraps around the 16 levels like in the lockstep engine
+    pc = stack[sp & 0xFu];
 }
 
 void Chip8::OP_1NNN() {
-    uint16_t addr = opcode & 0x0FFFu;
+    uint16_t addr = args.nnn;
     pc = addr;
 }
 
 void Chip8::OP_2NNN() {
-    uint16_t addr = opcode & 0x0FFFu;
-    stack[sp++] = pc;
+    uint16_t addr = args.nnn;
+    stack[sp++ & 0xFu] = pc;
     pc = addr;
 }
 
+template<typename Quirks>
 void Chip8::OP_3XNN() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
-    uint8_t val = opcode & 0x00FFu;
-    if(val == registers[reg]) pc += 2;
+    uint8_t reg = args.x;
+    uint8_t val = args.nn;
+    if(val == registers[reg]) skipNext<Quirks>();
 }
 
+template<typename Quirks>
 void Chip8::OP_4XNN() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
-    uint8_t val = opcode & 0x00FFu;
-    if(registers[reg] != val) pc += 2;
+    uint8_t reg = args.x;
+    uint8_t val = args.nn;
+    if(registers[reg] != val) skipNext<Quirks>();
 }
 
+template<typename Quirks>
 void Chip8::OP_5XY0() {
-    uint8_t reg1 = (opcode & 0x0F00u) >> 8u;
-    uint8_t reg2 = (opcode & 0x00F0U) >> 4u;
+    uint8_t reg1 = args.x;
+    uint8_t reg2 = args.y;
 
-    if(registers[reg1] == registers[reg2]) pc += 2;
+    if(registers[reg1] == registers[reg2]) skipNext<Quirks>();
 }
 
 void Chip8::OP_6XNN() {
-    uint8_t val = (opcode & 0x00FFu);
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t val = args.nn;
+    uint8_t reg = args.x;
     registers[reg] = val;
 }
 
 void Chip8::OP_7XNN() {
-    uint8_t val = (opcode & 0x00FFu);
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t val = args.nn;
+    uint8_t reg = args.x;
     registers[reg] += val;
 }
 
 void Chip8::OP_8XY0() {
-    uint8_t reg1 = (opcode & 0x0F00u) >> 8u;
-    uint8_t reg2 = (opcode & 0x00F0U) >> 4u;
+    uint8_t reg1 = args.x;
+    uint8_t reg2 = args.y;
 
     registers[reg1] = registers[reg2];
 }
 
+template<typename Quirks>
 void Chip8::OP_8XY1() {
-    uint8_t reg1 = (opcode & 0x0F00u) >> 8u;
-    uint8_t reg2 = (opcode & 0x00F0U) >> 4u;
+    uint8_t reg1 = args.x;
+    uint8_t reg2 = args.y;
 
     registers[reg1] = registers[reg1] | registers[reg2];
+    if constexpr(Quirks::vfReset) registers[0xF] = 0;
 }
 
+template<typename Quirks>
 void Chip8::OP_8XY2() {
-    uint8_t reg1 = (opcode & 0x0F00u) >> 8u;
-    uint8_t reg2 = (opcode & 0x00F0U) >> 4u;
+    uint8_t reg1 = args.x;
+    uint8_t reg2 = args.y;
 
     registers[reg1] = registers[reg1] & registers[reg2];
+    if constexpr(Quirks::vfReset) registers[0xF] = 0;
 }
 
+template<typename Quirks>
 void Chip8::OP_8XY3() {
-    uint8_t reg1 = (opcode & 0x0F00u) >> 8u;
-    uint8_t reg2 = (opcode & 0x00F0U) >> 4u;
+    uint8_t reg1 = args.x;
+    uint8_t reg2 = args.y;
 
     registers[reg1] = registers[reg1] ^ registers[reg2];
+    if constexpr(Quirks::vfReset) registers[0xF] = 0;
 }
 
 void Chip8::OP_8XY4() {
-    uint8_t regX = (opcode & 0x0F00u) >> 8u;
-    uint8_t regY = (opcode & 0x00F0U) >> 4u;
+    uint8_t regX = args.x;
+    uint8_t regY = args.y;
 
     uint16_t result = registers[regX] + registers[regY];
     bool cy = (result > 0xFFu);
@@ -244,8 +787,8 @@ void Chip8::OP_8XY4() {
 }
 
 void Chip8::OP_8XY5() {
-    uint8_t regX = (opcode & 0x0F00u) >> 8u;
-    uint8_t regY = (opcode & 0x00F0U) >> 4u;
+    uint8_t regX = args.x;
+    uint8_t regY = args.y;
 
     bool borrow = (registers[regX] > registers[regY]);
     registers[0xF] = borrow; //realisticaly this is !borrow
@@ -253,17 +796,18 @@ void Chip8::OP_8XY5() {
     registers[regX] -= registers[regY];
 }
 
+template<typename Quirks>
 void Chip8::OP_8XY6() {
-    uint8_t regX = (opcode & 0x0F00u) >> 8u;
-    uint8_t regY = (opcode & 0x00F0U) >> 4u;
+    uint8_t regX = args.x;
+    uint8_t regY = Quirks::shiftVx ? args.x : args.y;
 
     registers[regX] = (registers[regY] >> 1u);
     registers[0xF] = registers[regY] & 0x01u;
 }
 
 void Chip8::OP_8XY7() {
-    uint8_t regX = (opcode & 0x0F00u) >> 8u;
-    uint8_t regY = (opcode & 0x00F0U) >> 4u;
+    uint8_t regX = args.x;
+    uint8_t regY = args.y;
 
     bool borrow = (registers[regY] > registers[regX]);
     registers[0xF] = borrow; //realisticaly this is !borrow
@@ -271,101 +815,158 @@ void Chip8::OP_8XY7() {
     registers[regX] = registers[regY] - registers[regX];
 }
 
+template<typename Quirks>
 void Chip8::OP_8XYE() {
-    uint8_t regX = (opcode & 0x0F00u) >> 8u;
-    uint8_t regY = (opcode & 0x00F0U) >> 4u;
+    uint8_t regX = args.x;
+    uint8_t regY = Quirks::shiftVx ? args.x : args.y;
 
     registers[regX] = (registers[regY] << 1u);
     registers[0xF] = (registers[regY] & 0x80u) >> 7u;
 }
 
+template<typename Quirks>
 void Chip8::OP_9XY0() {
-    uint8_t reg1 = (opcode & 0x0F00u) >> 8u;
-    uint8_t reg2 = (opcode & 0x00F0U) >> 4u;
+    uint8_t reg1 = args.x;
+    uint8_t reg2 = args.y;
 
-    if(registers[reg1] != registers[reg2]) pc += 2;
+    if(registers[reg1] != registers[reg2]) skipNext<Quirks>();
 }
 
 void Chip8::OP_ANNN() {
-    uint16_t addr = opcode & 0x0FFFu;
+    uint16_t addr = args.nnn;
     vi = addr;
 }
 
+template<typename Quirks>
 void Chip8::OP_BNNN() {
-    uint16_t addr = opcode & 0x0FFFu;
-    pc = addr + registers[0x0];
+    uint16_t addr = args.nnn;
+    pc = addr + registers[Quirks::jumpVx ? args.x : 0x0];
 }
 
 void Chip8::OP_CXNN() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
-    uint8_t mask = opcode & 0x00FFu;
-    uint8_t rand = randByte(randomEngine);
+    uint8_t reg = args.x;
+    uint8_t mask = args.nn;
+    //the top bits of xorshift64* are the best ones, and unlike a std distribution
+    //the sequence does not depend on the standard library
+    uint8_t rand = static_cast<uint8_t>(randomEngine() >> 56u);
 
     registers[reg] = rand & mask;
 
 }
 
+template<typename Quirks>
 void Chip8::OP_DXYN() {
-    uint8_t regX = (opcode & 0x0F00) >> 8u;
-    uint8_t regY = (opcode & 0x00F0) >> 4u;
-    uint8_t bytes = opcode & 0x000F;
-
-    //wrap if going beyond screen boundaries
-    uint8_t xPos = registers[regX] & (DISPLAY_WIDTH - 1);
-    uint8_t yPos = registers[regY] & (DISPLAY_HEIGHT - 1);
-    if(xPos > DISPLAY_WIDTH - 1 || xPos < 0 || yPos < 0 || yPos > DISPLAY_HEIGHT - 1) {
+    if constexpr(Quirks::extended) {
+        drawExtended<Quirks>();
         return;
     }
-    //set to 0 if no overlap, 1 otherwise
-    registers[0xF] = 0;
-
-    for(uint8_t row = 0; row < bytes; row++) {
-        uint8_t sprite_byte = memory[vi + row];
+    uint8_t regX = args.x;
+    uint8_t regY = args.y;
+    uint8_t bytes = args.n;
+    const std::size_t width = FrameBuffer::LORES_WIDTH;
+    const std::size_t height = FrameBuffer::LORES_HEIGHT;
+
+    //wrap the starting position if going beyond screen boundaries
+    uint8_t xPos = registers[regX] & (width - 1);
+    uint8_t yPos = registers[regY] & (height - 1);
+
+    //the part of the sprite below the bottom edge is clipped, or drawn at the top when wrapping
+    uint8_t rows = Quirks::wrapSprites ? bytes : std::min<uint8_t>(bytes, height - yPos);
+
+    //plain CHIP-8 only ever draws on the left words of the first plane
+    std::array<std::uint64_t, FrameBuffer::HEIGHT>& screen = display.planes[0].left;
+    std::uint64_t collision = 0;
+    for(uint8_t row = 0; row < rows; row++) {
+        //move the 8 sprite pixels to column xPos, pixels beyond the right edge fall off the word
+        std::uint64_t sprite = std::uint64_t(memory[(vi + row) & Quirks::addressMask]) << (width - 8);
+        std::uint64_t sprite_row = sprite >> xPos;
+        if constexpr(Quirks::wrapSprites) {
+            //or come back in at the left edge
+            if(xPos > width - 8) sprite_row |= sprite << (width - xPos);
+        }
+        std::uint64_t& screen_row = screen[(yPos + row) & (height - 1)];
 
-        //the sprite is guaranteed to have 8 columns
-        for(uint8_t col = 0; col < 8; col++) {
-            //extract the specific bit
-            uint8_t sprite_pixel = sprite_byte & (0x80u >> col);
-            bool* screen_pixel = &display[(yPos + row) * DISPLAY_WIDTH + (xPos + col)];
+        //set to 1 if any pixel gets turned off, 0 otherwise
+        collision |= screen_row & sprite_row;
+        CHIP8_PROFILE_HOOK(profile.pixelsToggled += std::bitset<64>(sprite_row).count());
 
-            if(sprite_pixel) {
-                //collision
-                if(*screen_pixel == 1) {
-                    registers[0xF] = 1;
-                }
+        //XOR the sprite row with the row currently on the screen
+        screen_row ^= sprite_row;
+    }
+    registers[0xF] = collision != 0;
+    CHIP8_PROFILE_HOOK(profile.collisions += collision != 0);
+    ++displayGeneration;
+}
 
-                //XOR the pixel with a pixel currently on the screen
-                *screen_pixel ^= 1;
+template<typename Quirks>
+void Chip8::drawExtended() {
+    const std::size_t width = display.width();
+    const std::size_t height = display.height();
+    std::size_t xPos = registers[args.x] & (width - 1);
+    std::size_t yPos = registers[args.y] & (height - 1);
+
+    //DXY0 is a 16x16 sprite of two bytes per row
+    bool large = args.n == 0;
+    std::size_t spriteWidth = large ? 16 : 8;
+    std::size_t bytes = large ? 32 : args.n;
+    std::size_t rows = large ? 16 : args.n;
+    if(!Quirks::wrapSprites) rows = std::min(rows, height - yPos);
+
+    bool collision = false;
+    std::uint16_t address = vi;
+    //what is left of the sprite after clipping, as in the lores path
+    std::uint64_t* toggled = nullptr;
+    CHIP8_PROFILE_HOOK(toggled = &profile.pixelsToggled);
+    for(std::size_t plane = 0; plane < FrameBuffer::PLANES; plane++) {
+        if(!(planeMask & (1u << plane))) continue;
+        for(std::size_t row = 0; row < rows; row++) {
+            std::uint64_t sprite;
+            if(large) {
+                sprite = (std::uint64_t(memory[(address + 2 * row) & Quirks::addressMask]) << 8u) |
+                         memory[(address + 2 * row + 1) & Quirks::addressMask];
+            }
+            else {
+                sprite = memory[(address + row) & Quirks::addressMask];
             }
+            sprite <<= 64 - spriteWidth;
+            collision |= display.drawRow(plane, xPos, (yPos + row) & (height - 1), sprite, spriteWidth, Quirks::wrapSprites, toggled);
         }
+        //the next plane's sprite follows this one
+        address += bytes;
     }
+    registers[0xF] = collision;
+    CHIP8_PROFILE_HOOK(profile.collisions += collision);
+    ++displayGeneration;
 }
 
+template<typename Quirks>
 void Chip8::OP_EX9E() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
-    uint8_t key = registers[reg];
+    uint8_t reg = args.x;
+    //only the low nibble names a key
+    uint8_t key = registers[reg] & 0x0Fu;
 
     if(keyPad[key]) {
-        pc += 2;
+        skipNext<Quirks>();
     }
 }
 
+template<typename Quirks>
 void Chip8::OP_EXA1() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
-    uint8_t key = registers[reg];
+    uint8_t reg = args.x;
+    uint8_t key = registers[reg] & 0x0Fu;
 
     if(!keyPad[key]) {
-        pc += 2;
+        skipNext<Quirks>();
     }
 }
 
 void Chip8::OP_FX07() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t reg = args.x;
     registers[reg] = delay_timer;
 }
 
 void Chip8::OP_FX0A() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t reg = args.x;
     bool pressed = false;
     for(int i = 0; i < keyPad.size(); i++) {
         if(keyPad[i]) {
@@ -375,52 +976,168 @@ void Chip8::OP_FX0A() {
         }
     }
     //this will make the instruction run in an endless loop
-    if(!pressed) pc -= 2;
+    if(!pressed) {
+        pc -= 2;
+        CHIP8_PROFILE_HOOK(++profile.keyWaitCycles);
+    }
 }
 
 void Chip8::OP_FX15() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t reg = args.x;
     delay_timer = registers[reg];
 }
 
 void Chip8::OP_FX18() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t reg = args.x;
     sound_timer = registers[reg];
 }
 
 void Chip8::OP_FX1E() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t reg = args.x;
     vi += registers[reg];
 }
 
 void Chip8::OP_FX29() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t reg = args.x;
     vi = fontset_start_address + (5 * registers[reg]);
 }
 
+template<typename Quirks>
 void Chip8::OP_FX33() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t reg = args.x;
 
     //binary coded decimal equivalent
     uint8_t val = registers[reg];
     uint8_t k;
     for(int i = 2; i >= 0; i--) {
         k = val % 10;
-        memory[vi + i] = k;
+        memory[(vi + i) & Quirks::addressMask] = k;
         val /= 10;
     }
+    invalidateCode(vi, 3, Quirks::addressMask);
 }
 
+template<typename Quirks>
 void Chip8::OP_FX55() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t reg = args.x;
     for(uint8_t i = 0u; i <= reg; i++) {
-        memory[vi + i] = registers[i];
+        memory[(vi + i) & Quirks::addressMask] = registers[i];
     }
+    invalidateCode(vi, reg + 1, Quirks::addressMask);
+    if constexpr(Quirks::memoryIncrement) vi += reg + 1;
 }
 
+template<typename Quirks>
 void Chip8::OP_FX65() {
-    uint8_t reg = (opcode & 0x0F00u) >> 8u;
+    uint8_t reg = args.x;
     for(uint8_t i = 0u; i <= reg; i++) {
-        registers[i] = memory[vi + i];
+        registers[i] = memory[(vi + i) & Quirks::addressMask];
+    }
+    if constexpr(Quirks::memoryIncrement) vi += reg + 1;
+}
+
+template<typename Quirks>
+void Chip8::skipNext() {
+    if constexpr(Quirks::extended) {
+        //F000 NNNN is skipped as a whole
+        if(fetch(pc) == 0xF000u) {
+            pc += 4;
+            return;
+        }
+    }
+    pc += 2;
+}
+
+void Chip8::OP_00CN() {
+    display.scrollDown(args.n, planeMask);
+    ++displayGeneration;
+}
+
+void Chip8::OP_00DN() {
+    display.scrollUp(args.n, planeMask);
+    ++displayGeneration;
+}
+
+void Chip8::OP_00FB() {
+    display.scrollRight(4, planeMask);
+    ++displayGeneration;
+}
+
+void Chip8::OP_00FC() {
+    display.scrollLeft(4, planeMask);
+    ++displayGeneration;
+}
+
+void Chip8::OP_00FD() {
+    //there is no interpreter to return to, spin on this instruction
+    pc -= 2;
+}
+
+void Chip8::OP_00FE() {
+    display.setHires(false);
+    ++displayGeneration;
+}
+
+void Chip8::OP_00FF() {
+    display.setHires(true);
+    ++displayGeneration;
+}
+
+template<typename Quirks>
+void Chip8::OP_5XY2() {
+    uint8_t first = std::min(args.x, args.y);
+    uint8_t last = std::max(args.x, args.y);
+    for(uint8_t i = 0; i <= last - first; i++) {
+        //VX goes to I even when X > Y
+        uint8_t reg = args.x <= args.y ? args.x + i : args.x - i;
+        memory[(vi + i) & Quirks::addressMask] = registers[reg];
     }
-}
\ No newline at end of file
+    invalidateCode(vi, last - first + 1, Quirks::addressMask);
+}
+
+template<typename Quirks>
+void Chip8::OP_5XY3() {
+    uint8_t first = std::min(args.x, args.y);
+    uint8_t last = std::max(args.x, args.y);
+    for(uint8_t i = 0; i <= last - first; i++) {
+        uint8_t reg = args.x <= args.y ? args.x + i : args.x - i;
+        registers[reg] = memory[(vi + i) & Quirks::addressMask];
+    }
+}
+
+void Chip8::OP_F000() {
+    //the address is the next word, which is stepped over
+    vi = fetch(pc);
+    pc += 2;
+}
+
+void Chip8::OP_FN01() {
+    planeMask = args.x & 0x3u;
+}
+
+template<typename Quirks>
+void Chip8::OP_F002() {
+    for(std::size_t i = 0; i < audioPattern.size(); i++) {
+        audioPattern[i] = memory[(vi + i) & Quirks::addressMask];
+    }
+}
+
+void Chip8::OP_FX30() {
+    vi = big_fontset_start_address + 10 * (registers[args.x] & 0x0Fu);
+}
+
+void Chip8::OP_FX3A() {
+    pitch = registers[args.x];
+}
+
+void Chip8::OP_FX75() {
+    for(uint8_t i = 0; i <= args.x; i++) {
+        flags[i] = registers[i];
+    }
+}
+
+void Chip8::OP_FX85() {
+    for(uint8_t i = 0; i <= args.x; i++) {
+        registers[i] = flags[i];
+    }
+}
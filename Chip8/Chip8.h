@@ -6,59 +6,131 @@
 #include <iostream>
 #include <random>
 #include <ctime>
+#include <vector>
+#include <memory>
+#include <algorithm>
 
 #include "FailStates.h"
+#include "FrameBuffer.h"
+#include "Hash.h"
+#include "OpTable.h"
+#include "Profile.h"
+#include "Quirks.h"
+#include "RandomEngine.h"
 
 typedef long long ll;
 typedef void (*Instruction)(void);
 
 struct Chip8 {
 
+    //seeded from the clock, runs differ in their random numbers
     Chip8();
+    //the same seed, ROM and input always give the same run
+    explicit Chip8(std::uint64_t seed);
 
     const static unsigned int start_address = 0x200;
     const static unsigned int fontset_start_address = 0x50;
     const static unsigned int fontset_size = 80;
+    //the 8x10 SUPER-CHIP digits, right after the small ones
+    const static unsigned int big_fontset_start_address = 0xA0;
+    const static unsigned int big_fontset_size = 160;
 
-    const static uint8_t DISPLAY_WIDTH = 64;
-    const static uint8_t DISPLAY_HEIGHT = 32;
+    //the 16-bit address space, only XO-CHIP has memory in all of it, the other profiles have the first 4 KB
+    const static std::size_t MEMORY_SIZE = 0x10000;
+    //everything between start_address and the end of memory, the largest ROM of any profile (XO-CHIP)
+    const static std::size_t MAX_ROM_SIZE = MEMORY_SIZE - start_address;
+    //granularity of writtenPages
+    const static std::size_t PAGE_SIZE = 256;
 
-    bool romLoaded{false};
-
-    //temporary
-    std::uint16_t program_size{};
+    typedef void (Chip8::*Chip8Func)();
 
-    //random engine for the random function
-    std::default_random_engine randomEngine;
-    std::uniform_int_distribution<std::uint8_t> randByte;
+    /**
+     * Handlers of every instruction under one quirk profile.
+     * main is indexed by the first nibble, table0 and tableF by the low byte,
+     * table5, table8 and tableE by the last nibble.
+     * Built at compile time, one instance per profile is shared by every Chip8
+     */
+    struct DispatchTables {
+        std::array<Chip8Func, 0xF + 1> main;
+        //00CN, 00DN and 00FB-00FF
+        std::array<Chip8Func, 0xFF + 1> table0;
+        std::array<Chip8Func, 0xF + 1> table5;
+        std::array<Chip8Func, 0xE + 1> table8;
+        std::array<Chip8Func, 0xE + 1> tableE;
+        std::array<Chip8Func, 0x85 + 1> tableF;
+    };
 
-    typedef void (Chip8::*Chip8Func)();
-    //instruction table
-    std::array<Chip8Func, 0xF + 1> instructionTable;
-    std::array<Chip8Func, 0xE + 1> table0;
-    std::array<Chip8Func, 0xE + 1> table8;
-    std::array<Chip8Func, 0xE + 1> tableE;
-    std::array<Chip8Func, 0x65 + 1> tableF;
+    /**
+     * The tables of the handlers specialized for Quirks
+     */
+    template<typename Quirks>
+    static constexpr DispatchTables makeDispatchTables();
 
+    template<typename Quirks>
     void Table0();
+    template<typename Quirks>
+    void Table5();
+    template<typename Quirks>
     void Table8();
+    template<typename Quirks>
     void TableE();
+    template<typename Quirks>
     void TableF();
 
-    //trenutni opcode
-    std::uint16_t opcode{};
+    /**
+     * The handler of an instruction specialized for Quirks,
+     * a constant the threaded engine and the JIT resolve once
+     */
+    template<typename Quirks>
+    static constexpr Chip8Func handlerFor(Op op);
+
+    /**
+     * Operands of an instruction, split out of the opcode once
+     * so the handlers do not mask and shift them again
+     */
+    struct Operands {
+        std::uint8_t x;
+        std::uint8_t y;
+        std::uint8_t n;
+        std::uint8_t nn;
+        std::uint16_t nnn;
+    };
+
+    /**
+     * An instruction decoded once: the final handler, with table0/8/E/F
+     * already resolved, and its operands
+     */
+    struct DecodedOp {
+        Chip8Func handler;
+        Operands args;
+        std::uint16_t opcode;
+    };
+
+    enum class Engine : std::uint8_t {
+        //fetch and decode every instruction through the tables
+        Interpreter,
+        //decode every word once and replay it from decodedOps
+        DecodeCache,
+        //one indirect jump per instruction through OP_TABLE (computed goto, switch elsewhere)
+        Threaded
+    };
+
+    //the state every instruction touches comes first and fills exactly one cache line
 
     //16 8-bit, multi-purpose registers
-    std::array<std::uint8_t, 16> registers;
+    alignas(64) std::array<std::uint8_t, 16> registers{};
+
+    //16-bit program counter (PC)
+    std::uint16_t pc{};
 
     //special 16-bit index register
     std::uint16_t vi{};
 
-    //16-bit program counter (PC)
-    std::uint16_t pc{};
+    //trenutni opcode
+    std::uint16_t opcode{};
 
-    //16-level stack of 16 bit values
-    std::array<std::uint16_t, 16> stack{};
+    //operands of the instruction being executed
+    Operands args{};
 
     //8-bit stack pointer
     std::uint8_t sp{};
@@ -69,6 +141,31 @@ struct Chip8 {
     //8-bit sound timer
     std::uint8_t sound_timer{};
 
+    //behaviour of the ambiguous instructions, like the engine not part of the save state
+    QuirkProfile quirks{QuirkProfile::Default};
+
+    Engine engine{Engine::Interpreter};
+
+    //fast-forward loops that can only be left by a timer tick or a key press
+    bool idleSkipping{true};
+
+    //dispatch tables of the selected quirk profile
+    const DispatchTables* tables;
+
+    //instructions executed since power on, input logs are stamped with it
+    std::uint64_t cycleCount{};
+
+    //random engine for the random function
+    RandomEngine randomEngine;
+
+    //16-level stack of 16 bit values
+    std::array<std::uint16_t, 16> stack{};
+
+    //range of memory written by the ROM since the last clearCodeWrites(),
+    //lets translators outside the core (the JIT) drop their stale code
+    std::uint16_t codeWriteBegin{0xFFFF};
+    std::uint16_t codeWriteEnd{0};
+
     //keymap for 16 available keys
 
     //recommended key mappings
@@ -85,14 +182,55 @@ struct Chip8 {
 //    +-+-+-+-+    +-+-+-+-+
     std::array<bool, 16> keyPad{};
 
-    //4 kilobytes of memory
-    std::array<std::uint8_t, 4096> memory{};
+    //XO-CHIP FN01: the planes that 00E0, DXYN and the scrolls work on
+    std::uint8_t planeMask{1};
+
+    //XO-CHIP F002 sample and FX3A playback rate, played while the sound timer runs
+    std::uint8_t pitch{64};
+    std::array<std::uint8_t, 16> audioPattern{};
+
+    //SUPER-CHIP FX75/FX85 user flags, the HP48 RPL registers
+    std::array<std::uint8_t, 16> flags{};
+
+    //incremented by every instruction that touches the display (00E0, DXYN),
+    //renderers only redraw when it changed since their last frame
+    std::uint32_t displayGeneration{};
+
+    bool romLoaded{false};
+
+    //temporary
+    std::uint16_t program_size{};
+
+    //instructions of cycleCount that were skipped instead of executed
+    std::uint64_t idleCycles{};
+
+    //memory written since the last reset, [dirtyBegin, dirtyEnd), the only part reset() has to restore
+    std::uint16_t dirtyBegin{0xFFFF};
+    std::uint32_t dirtyEnd{0};
+
+    //bit per PAGE_SIZE bytes of memory written since the last clearWrittenPages(),
+    //copy-on-write snapshots (ForkTree) only copy these pages
+    std::array<std::uint64_t, MEMORY_SIZE / PAGE_SIZE / 64> writtenPages{};
+
+    //the loaded ROM as it was before it ran, shared by copies of this instance
+    std::shared_ptr<const std::vector<std::uint8_t>> romImage;
+
+    //indexed by the address of the instruction, empty unless the DecodeCache engine is selected
+    std::vector<DecodedOp> decodedOps;
+
+#ifdef CHIP8_PROFILE
+    //opcode histogram, hot addresses, draw and key wait counters
+    Profile profile;
+#endif
 
-    //B&W, 64*32(2048) bytes large display memory
-    std::array<bool, 64*32> display{};
+    //64x32 or 128x64, two bitplanes of packed rows
+    FrameBuffer display;
+
+    //what the quirk profile reaches through I, addressableMemory(quirks) bytes: 4 KB, 64 KB on XO-CHIP
+    std::vector<std::uint8_t> memory;
 
     //the standard font set
-    const std::array<uint8_t, fontset_size> fontSet = {
+    static constexpr std::array<uint8_t, fontset_size> fontSet = {
             0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
             0x20, 0x60, 0x20, 0x20, 0x70, // 1
             0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
@@ -111,17 +249,204 @@ struct Chip8 {
             0xF0, 0x80, 0xF0, 0x80, 0x80  // F
     };
 
+    //the large hexadecimal digits of SUPER-CHIP and XO-CHIP, loaded for those profiles
+    static constexpr std::array<uint8_t, big_fontset_size> bigFontSet = {
+            0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, // 0
+            0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, // 1
+            0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // 2
+            0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 3
+            0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, // 4
+            0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 5
+            0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 6
+            0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, // 7
+            0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 8
+            0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 9
+            0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+            0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+            0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+            0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+            0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+            0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+    };
+
     /**
      *
      * @param filePath: Absolute path to the ROM file
+     * @return: FailStates::SUCCESS, or why the ROM was not loaded
+     */
+    std::uint8_t loadRom(const std::string& filePath);
+
+    /**
+     * Load a ROM that is already in memory, e.g. a RomLibrary image, without any file I/O
+     * @return: FailStates::SUCCESS, ROM_EMPTY or ROM_TOO_LARGE
+     */
+    std::uint8_t loadRom(const std::uint8_t* data, std::size_t size);
+
+    /**
+     * @return: Size of the largest ROM the selected quirk profile takes, the memory it reaches
+     * through I above start_address. Select the profile before loading the ROM
+     */
+    std::size_t maxRomSize() const;
+
+    /**
+     * Restart the random number sequence used by CXNN
+     */
+    void seedRandom(std::uint64_t seed);
+
+    /**
+     * Back to the state right after loadRom, as if constructed with seed and loaded again.
+     * Only the memory written since the last reset is restored, so this costs a few hundred
+     * nanoseconds instead of a construction. The engine, quirk profile and idle skipping stay
      */
-    void loadRom(const std::string& filePath);
+    void reset(std::uint64_t seed);
+
+    //save states: a header followed by the raw machine state in host byte order
+    const static std::uint32_t STATE_MAGIC = 0x53533843; //"C8SS"
+    const static std::uint16_t STATE_VERSION = 3;
+    const static std::size_t STATE_HEADER_SIZE = 12;
+
+    /**
+     * @return: Size in bytes of a save state
+     */
+    static std::size_t stateSize();
+
+    /**
+     * Copy the complete machine state, including the random engine, into buffer
+     * @return: Bytes written, 0 if the buffer is smaller than stateSize()
+     */
+    std::size_t saveState(std::uint8_t* buffer, std::size_t size) const;
+    std::vector<std::uint8_t> saveState() const;
+
+    /**
+     * Restore a state written by saveState, the instance then continues bit for bit
+     * like the one that saved it. The engine selection is not part of the state
+     * @return: false if the buffer is not a save state of this version
+     */
+    bool loadState(const std::uint8_t* buffer, std::size_t size);
+
+    /**
+     * The fields of a save state without header and memory, for callers that keep
+     * memory themselves page by page (RewindBuffer). coreStateSize() bytes each
+     */
+    static std::size_t coreStateSize();
+    void saveCoreState(std::uint8_t* buffer) const;
+    void loadCoreState(const std::uint8_t* buffer);
+
+    /**
+     * FNV-1a hashes of the machine state, used to compare runs
+     * of the same ROM across engines, hosts and processes
+     */
+    std::uint64_t registersHash() const;
+    std::uint64_t memoryHash() const;
+    std::uint64_t displayHash() const;
+
+    /**
+     * @return: Colour of the pixel at column x and row y, bit n set if it is lit on plane n
+     */
+    std::uint8_t pixel(std::size_t x, std::size_t y) const {
+        return display.pixel(x, y);
+    }
+
+    /**
+     * Unpack the display into one colour byte per pixel, row by row
+     * @param out: display.width() * display.height() bytes
+     */
+    void unpackDisplay(std::uint8_t* out) const;
+
+    /**
+     * Select the execution engine, can be switched at any time
+     */
+    void setEngine(Engine newEngine);
+
+    /**
+     * Select the quirk profile, can be switched at any time.
+     * Decoded and compiled code is dropped since it was specialized for the old profile
+     */
+    void setQuirks(QuirkProfile profile);
+
+    /**
+     * Must be called after writing to memory, drops the decoded instructions
+     * that overlap the written bytes so self-modifying ROMs stay correct
+     * @param address: First written byte
+     * @param length: Number of written bytes
+     * @param addressMask: Quirks::addressMask of a write through I, which wraps at addressMask + 1
+     */
+    void invalidateCode(std::uint16_t address, std::uint32_t length, std::uint16_t addressMask = MEMORY_SIZE - 1);
+
+    /**
+     * Forget the recorded written range, called by the owner after handling it
+     */
+    void clearCodeWrites();
+
+    /**
+     * Forget the recorded written pages, called by the owner after handling them
+     */
+    void clearWrittenPages();
+
+    static Operands splitOperands(std::uint16_t opcode);
+
+    /**
+     * The instruction an opcode is under the selected quirk profile
+     */
+    Op opOf(std::uint16_t opcode) const {
+        return (extendedInstructions(quirks) ? EXTENDED_OP_TABLE : OP_TABLE)[opTableIndex(opcode)];
+    }
+
+    /**
+     * The instruction at address. Every profile fetches from the whole address space, above its
+     * memory the bytes read as zero, and an instruction at 0xFFFF ends with the byte at address 0
+     */
+    std::uint16_t fetch(std::uint16_t address) const {
+        if(address + 1u < memory.size()) return (memory[address] << 8u) | memory[address + 1];
+        std::uint16_t next = address + 1;
+        return ((address < memory.size() ? memory[address] : 0) << 8u) | (next < memory.size() ? memory[next] : 0);
+    }
+
+    /**
+     * Step over the next instruction, with Quirks::extended that is all 4 bytes of an F000 NNNN
+     */
+    template<typename Quirks>
+    void skipNext();
+
+    /**
+     * Resolve the handler and operands of an opcode
+     */
+    DecodedOp decode(std::uint16_t opcode) const;
 
     /**
      * One instruction cycle
      */
     void cycle();
 
+    /**
+     * Decrement the delay and sound timers, called by the host once per 60 Hz frame
+     */
+    void tickTimers();
+
+    /**
+     * Execute the given number of instruction cycles on the selected engine
+     */
+    void run(std::uint64_t cycles);
+
+    //the threaded engine, one copy per quirk profile
+    template<typename Quirks>
+    void runThreaded(std::uint64_t cycles);
+
+    /**
+     * Number of instructions in one iteration of the idle loop at pc, 0 if pc is not in one.
+     * Recognized: 1NNN jumping to itself, FX0A with no key down, and FX07 / 3XNN / 1NNN
+     * spinning on the delay timer. Within a frame neither the timers nor the keypad change,
+     * so every iteration leaves the machine in the same state
+     */
+    std::uint8_t idleLoopLength() const;
+
+    /**
+     * Skip the whole iterations of the idle loop at pc that fit into remaining
+     * @param remaining: Instructions left until the next timer tick or input event, reduced by the skipped ones
+     * @return: Whether anything was skipped. The caller accounts the skipped instructions in cycleCount
+     */
+    bool skipIdle(std::uint64_t& remaining);
+
     /**
      * Execute the current instruction
      */
@@ -135,7 +460,7 @@ struct Chip8 {
 // Useless istruction
 //    void OP_0NNN();
 
-    /// 00E0: Clear the screen
+    /// 00E0: Clear the screen (256 bytes)
     void OP_00E0();
 
     /// 00EE: Return from a subroutine
@@ -148,12 +473,15 @@ struct Chip8 {
     void OP_2NNN();
 
     /// 3XNN: Skip the following instruction if the value of register VX equals NN
+    template<typename Quirks>
     void OP_3XNN();
 
     /// 4XNN: Skip the following instruction if the value of register VX is not equal to NN
+    template<typename Quirks>
     void OP_4XNN();
 
     /// 5XY0: Skip the following instruction if the value of register VX is equal to the value of register VY
+    template<typename Quirks>
     void OP_5XY0();
 
     /// 6XNN: Store number NN in register VX
@@ -165,13 +493,16 @@ struct Chip8 {
     /// 8XY0: Store the value of register VY in register VX
     void OP_8XY0();
 
-    /// 8XY1: Set VX to VX OR VY
+    /// 8XY1: Set VX to VX OR VY, VF is cleared with Quirks::vfReset
+    template<typename Quirks>
     void OP_8XY1();
 
-    /// 8XY2: Set VX to VX AND VY
+    /// 8XY2: Set VX to VX AND VY, VF is cleared with Quirks::vfReset
+    template<typename Quirks>
     void OP_8XY2();
 
-    /// 8XY3: Set VX to VX XOR VY
+    /// 8XY3: Set VX to VX XOR VY, VF is cleared with Quirks::vfReset
+    template<typename Quirks>
     void OP_8XY3();
 
     /**
@@ -185,34 +516,52 @@ struct Chip8 {
     /// 8XY5: Subtract the value of register VY from register VX
     void OP_8XY5();
 
-    /// 8XY6: Store the value of register VY shifted right one bit in register VX
+    /// 8XY6: Store the value of register VY (VX with Quirks::shiftVx) shifted right one bit in register VX
+    template<typename Quirks>
     void OP_8XY6();
 
     /// 8XY7: Set register VX to the value of VY minus VX
     void OP_8XY7();
 
-    /// 8XYE: Store the value of register VY shifted left one bit in register VX
+    /// 8XYE: Store the value of register VY (VX with Quirks::shiftVx) shifted left one bit in register VX
+    template<typename Quirks>
     void OP_8XYE();
 
     /// 9XY0: Skip the following instruction if the value of register VX is not equal to the value of register VY
+    template<typename Quirks>
     void OP_9XY0();
 
     /// ANNN: Store memory address NNN in register I
     void OP_ANNN();
 
-    /// BNNN: Jump to address NNN + V0
+    /// BNNN: Jump to address NNN + V0, or XNN + VX with Quirks::jumpVx
+    template<typename Quirks>
     void OP_BNNN();
 
     /// CXNN: Set VX to a random number with a mask of NN
     void OP_CXNN();
 
-    /// DXYN: Draw a sprite at position VX, VY with N bytes of sprite data starting at the address stored in I
+    /**
+     * DXYN: Draw a sprite at position VX, VY with N bytes of sprite data starting at the address stored in I
+     * Each sprite row is one shift, one AND for the collision and one XOR, clipped at the right and bottom edges
+     * or wrapped around them with Quirks::wrapSprites. With Quirks::extended DXY0 draws a 16x16 sprite,
+     * and every selected plane draws its own sprite, the one of plane 1 following the one of plane 0
+     */
+    template<typename Quirks>
     void OP_DXYN();
 
+    /**
+     * DXYN of the extended profiles: either resolution, DXY0 16x16 sprites, one sprite per selected plane
+     */
+    template<typename Quirks>
+    void drawExtended();
+
     /// EX9E: Skip the following instruction if the key corresponding to the hex value currently stored in register VX is pressed
+    template<typename Quirks>
     void OP_EX9E();
 
     /// EXA1: Skip the following instruction if the key corresponding to the hex value currently stored in register VX is not pressed
+    template<typename Quirks>
     void OP_EXA1();
 
     /// FX07: Store the current value of the delay timer in register VX
@@ -234,18 +583,74 @@ struct Chip8 {
     void OP_FX29();
 
     /// Store the binary-coded decimal equivalent of the value stored in register VX at addresses I, I + 1, and I + 2
+    template<typename Quirks>
     void OP_FX33();
 
     /**
      * Store the values of registers V0 to VX inclusive in memory starting at address
-     * I. I is set to I + X + 1 after operation
+     * I. With Quirks::memoryIncrement I is set to I + X + 1 after operation
      */
+    template<typename Quirks>
     void OP_FX55();
 
     /**
      * Fill registers V0 to VX inclusive with the values stored in memory starting at address I
-     * I is set to I + X + 1 after operation
+     * With Quirks::memoryIncrement I is set to I + X + 1 after operation
      */
+    template<typename Quirks>
     void OP_FX65();
 
+    //SUPER-CHIP and XO-CHIP instructions, decoded under the extended quirk profiles only
+
+    /// 00CN: Scroll the selected planes down N rows
+    void OP_00CN();
+
+    /// 00DN: Scroll the selected planes up N rows (XO-CHIP)
+    void OP_00DN();
+
+    /// 00FB: Scroll the selected planes right 4 pixels
+    void OP_00FB();
+
+    /// 00FC: Scroll the selected planes left 4 pixels
+    void OP_00FC();
+
+    /// 00FD: Exit the interpreter, execution stays on this instruction
+    void OP_00FD();
+
+    /// 00FE: Switch to 64x32 lores mode and clear the screen
+    void OP_00FE();
+
+    /// 00FF: Switch to 128x64 hires mode and clear the screen
+    void OP_00FF();
+
+    /// 5XY2: Store registers VX to VY, in either order, in memory starting at I. I is unchanged (XO-CHIP)
+    template<typename Quirks>
+    void OP_5XY2();
+
+    /// 5XY3: Load registers VX to VY, in either order, from memory starting at I. I is unchanged (XO-CHIP)
+    template<typename Quirks>
+    void OP_5XY3();
+
+    /// F000 NNNN: Load the 16-bit address NNNN into I, the instruction is 4 bytes long (XO-CHIP)
+    void OP_F000();
+
+    /// FN01: Select the planes N for drawing, clearing and scrolling (XO-CHIP)
+    void OP_FN01();
+
+    /// F002: Load the 16 byte audio pattern from memory starting at I (XO-CHIP)
+    template<typename Quirks>
+    void OP_F002();
+
+    /// FX30: Set I to the memory address of the large sprite for the hexadecimal digit in VX
+    void OP_FX30();
+
+    /// FX3A: Set the audio pattern playback rate to VX (XO-CHIP)
+    void OP_FX3A();
+
+    /// FX75: Store registers V0 to VX in the user flags
+    void OP_FX75();
+
+    /// FX85: Load registers V0 to VX from the user flags
+    void OP_FX85();
+
 };
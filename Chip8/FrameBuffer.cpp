@@ -0,0 +1,117 @@
+#include "FrameBuffer.h"
+
+#include <algorithm>
+
+#include "Hash.h"
+
+void FrameBuffer::clear(std::uint8_t mask) {
+    for(std::size_t plane = 0; plane < PLANES; plane++) {
+        if(!(mask & (1u << plane))) continue;
+        planes[plane].left.fill(0);
+        planes[plane].right.fill(0);
+    }
+}
+
+void FrameBuffer::setHires(bool enabled) {
+    hires = enabled;
+    clear(0xFF);
+}
+
+void FrameBuffer::scrollDown(std::size_t rows, std::uint8_t mask) {
+    std::size_t rowCount = height();
+    rows = std::min(rows, rowCount);
+    for(std::size_t plane = 0; plane < PLANES; plane++) {
+        if(!(mask & (1u << plane))) continue;
+        for(auto* words : {&planes[plane].left, &planes[plane].right}) {
+            std::copy_backward(words->begin(), words->begin() + (rowCount - rows), words->begin() + rowCount);
+            std::fill(words->begin(), words->begin() + rows, 0);
+        }
+    }
+}
+
+void FrameBuffer::scrollUp(std::size_t rows, std::uint8_t mask) {
+    std::size_t rowCount = height();
+    rows = std::min(rows, rowCount);
+    for(std::size_t plane = 0; plane < PLANES; plane++) {
+        if(!(mask & (1u << plane))) continue;
+        for(auto* words : {&planes[plane].left, &planes[plane].right}) {
+            std::copy(words->begin() + rows, words->begin() + rowCount, words->begin());
+            std::fill(words->begin() + (rowCount - rows), words->begin() + rowCount, 0);
+        }
+    }
+}
+
+void FrameBuffer::scrollRight(std::size_t columns, std::uint8_t mask) {
+    if(columns == 0) return;
+    if(columns >= width()) {
+        clear(mask);
+        return;
+    }
+    for(std::size_t plane = 0; plane < PLANES; plane++) {
+        if(!(mask & (1u << plane))) continue;
+        std::uint64_t* left = planes[plane].left.data();
+        std::uint64_t* right = planes[plane].right.data();
+        if(!hires) {
+            for(std::size_t y = 0; y < LORES_HEIGHT; y++) left[y] >>= columns;
+        }
+        else if(columns < 64) {
+            //independent rows, one vector shift and OR covers several of them
+            for(std::size_t y = 0; y < HEIGHT; y++) {
+                right[y] = (right[y] >> columns) | (left[y] << (64 - columns));
+                left[y] >>= columns;
+            }
+        }
+        else {
+            for(std::size_t y = 0; y < HEIGHT; y++) {
+                right[y] = left[y] >> (columns - 64);
+                left[y] = 0;
+            }
+        }
+    }
+}
+
+void FrameBuffer::scrollLeft(std::size_t columns, std::uint8_t mask) {
+    if(columns == 0) return;
+    if(columns >= width()) {
+        clear(mask);
+        return;
+    }
+    for(std::size_t plane = 0; plane < PLANES; plane++) {
+        if(!(mask & (1u << plane))) continue;
+        std::uint64_t* left = planes[plane].left.data();
+        std::uint64_t* right = planes[plane].right.data();
+        if(!hires) {
+            for(std::size_t y = 0; y < LORES_HEIGHT; y++) left[y] <<= columns;
+        }
+        else if(columns < 64) {
+            for(std::size_t y = 0; y < HEIGHT; y++) {
+                left[y] = (left[y] << columns) | (right[y] >> (64 - columns));
+                right[y] <<= columns;
+            }
+        }
+        else {
+            for(std::size_t y = 0; y < HEIGHT; y++) {
+                left[y] = right[y] << (columns - 64);
+                right[y] = 0;
+            }
+        }
+    }
+}
+
+std::uint64_t FrameBuffer::hash() const {
+    std::size_t rowCount = height();
+    std::uint64_t result = FNV_OFFSET_BASIS;
+    for(std::size_t plane = 0; plane < PLANES; plane++) {
+        const Plane& words = planes[plane];
+        //plane 0 always counts, the others only once something was drawn on them
+        if(plane > 0) {
+            bool empty = std::all_of(words.left.begin(), words.left.begin() + rowCount, [](std::uint64_t w) { return w == 0; }) &&
+                         (!hires || std::all_of(words.right.begin(), words.right.end(), [](std::uint64_t w) { return w == 0; }));
+            if(empty) continue;
+        }
+        result = fnv1a(words.left.data(), rowCount * sizeof(std::uint64_t), result);
+        if(hires) result = fnv1a(words.right.data(), rowCount * sizeof(std::uint64_t), result);
+    }
+    if(hires) result = fnv1a(&hires, sizeof(hires), result);
+    return result;
+}
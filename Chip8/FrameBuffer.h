@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <bitset>
+
+/**
+ * Two bitplanes of up to 128x64 pixels, one bit per pixel.
+ *
+ * Every plane keeps the left and the right 64 columns of its rows in two separate arrays,
+ * the most significant bit is the leftmost pixel. Sprite rows are placed with one or two
+ * shifts per word, and scrolls are straight loops of word shifts over whole arrays
+ * that the compiler turns into vector instructions.
+ *
+ * In lores mode only the left words of the first 32 rows are used,
+ * which is exactly the 64x32 layout of plain CHIP-8.
+ */
+struct FrameBuffer {
+    const static std::size_t WIDTH = 128;
+    const static std::size_t HEIGHT = 64;
+    const static std::size_t LORES_WIDTH = 64;
+    const static std::size_t LORES_HEIGHT = 32;
+    const static std::size_t PLANES = 2;
+
+    struct Plane {
+        alignas(32) std::array<std::uint64_t, HEIGHT> left;
+        alignas(32) std::array<std::uint64_t, HEIGHT> right;
+    };
+
+    std::array<Plane, PLANES> planes{};
+
+    //128x64 SUPER-CHIP mode
+    bool hires{false};
+
+    std::size_t width() const {
+        return hires ? WIDTH : LORES_WIDTH;
+    }
+
+    std::size_t height() const {
+        return hires ? HEIGHT : LORES_HEIGHT;
+    }
+
+    /**
+     * @return: Colour index of the pixel at column x and row y, bit n set if it is lit on plane n
+     */
+    std::uint8_t pixel(std::size_t x, std::size_t y) const {
+        std::uint8_t colour = 0;
+        for(std::size_t plane = 0; plane < PLANES; plane++) {
+            std::uint64_t word = x < 64 ? planes[plane].left[y] : planes[plane].right[y];
+            colour |= ((word >> (63 - (x & 63u))) & 1u) << plane;
+        }
+        return colour;
+    }
+
+    /**
+     * XOR a sprite row into a plane
+     * @param sprite: The sprite row in the most significant spriteWidth bits
+     * @param wrap: Pixels beyond the right edge come back in at the left edge instead of being clipped
+     * @param toggled: If not null, the number of pixels that were XORed onto the plane is added to it
+     * @return: Whether a lit pixel was turned off
+     */
+    bool drawRow(std::size_t plane, std::size_t x, std::size_t y, std::uint64_t sprite, std::size_t spriteWidth, bool wrap,
+                 std::uint64_t* toggled = nullptr) {
+        std::uint64_t left;
+        std::uint64_t right = 0;
+        if(!hires) {
+            left = sprite >> x;
+            if(wrap && x > LORES_WIDTH - spriteWidth) left |= sprite << (LORES_WIDTH - x);
+        }
+        else {
+            //the 128-bit row as two words, both shift counts stay below 64
+            left = x < 64 ? sprite >> x : 0;
+            right = x == 0 ? 0 : x < 64 ? sprite << (64 - x) : sprite >> (x - 64);
+            if(wrap && x > WIDTH - spriteWidth) left |= sprite << (WIDTH - x);
+        }
+
+        Plane& target = planes[plane];
+        bool collision = ((target.left[y] & left) | (target.right[y] & right)) != 0;
+        target.left[y] ^= left;
+        target.right[y] ^= right;
+        if(toggled != nullptr) *toggled += std::bitset<64>(left).count() + std::bitset<64>(right).count();
+        return collision;
+    }
+
+    /**
+     * Clear the planes in mask
+     */
+    void clear(std::uint8_t mask);
+
+    /**
+     * Switch between 64x32 and 128x64, clears every plane
+     */
+    void setHires(bool enabled);
+
+    /**
+     * Scroll the planes in mask, the pixels scrolled in are off.
+     * Amounts are in pixels of the current resolution
+     */
+    void scrollDown(std::size_t rows, std::uint8_t mask);
+    void scrollUp(std::size_t rows, std::uint8_t mask);
+    void scrollRight(std::size_t columns, std::uint8_t mask);
+    void scrollLeft(std::size_t columns, std::uint8_t mask);
+
+    /**
+     * FNV-1a of the visible area. Plain 64x32 single-plane screens hash
+     * exactly like the 64x32 display of earlier versions did
+     */
+    std::uint64_t hash() const;
+};
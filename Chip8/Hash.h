@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+//64-bit FNV-1a, cheap and good enough to fingerprint machine state and ROMs
+const std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+const std::uint64_t FNV_PRIME = 0x100000001b3ull;
+
+inline std::uint64_t fnv1a(const void* data, std::size_t size, std::uint64_t hash = FNV_OFFSET_BASIS) {
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    for(std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+//every instruction the core implements, in the order of the dispatch tables,
+//followed by the SUPER-CHIP and XO-CHIP extensions
+#define CHIP8_OPS(X) \
+    X(OP_NULL) \
+    X(OP_00E0) X(OP_00EE) X(OP_1NNN) X(OP_2NNN) X(OP_3XNN) X(OP_4XNN) X(OP_5XY0) \
+    X(OP_6XNN) X(OP_7XNN) X(OP_8XY0) X(OP_8XY1) X(OP_8XY2) X(OP_8XY3) X(OP_8XY4) \
+    X(OP_8XY5) X(OP_8XY6) X(OP_8XY7) X(OP_8XYE) X(OP_9XY0) X(OP_ANNN) X(OP_BNNN) \
+    X(OP_CXNN) X(OP_DXYN) X(OP_EX9E) X(OP_EXA1) X(OP_FX07) X(OP_FX0A) X(OP_FX15) \
+    X(OP_FX18) X(OP_FX1E) X(OP_FX29) X(OP_FX33) X(OP_FX55) X(OP_FX65) \
+    X(OP_00CN) X(OP_00DN) X(OP_00FB) X(OP_00FC) X(OP_00FD) X(OP_00FE) X(OP_00FF) \
+    X(OP_5XY2) X(OP_5XY3) X(OP_F000) X(OP_FN01) X(OP_F002) X(OP_FX30) X(OP_FX3A) \
+    X(OP_FX75) X(OP_FX85)
+
+#define CHIP8_OP_ENUM(name) name,
+enum class Op : std::uint8_t {
+    CHIP8_OPS(CHIP8_OP_ENUM)
+    COUNT
+};
+#undef CHIP8_OP_ENUM
+
+/**
+ * The first nibble and the low byte of an opcode are enough to tell every
+ * instruction apart, so the flat table has 16 * 256 entries instead of 64K
+ */
+constexpr std::size_t opTableIndex(std::uint16_t opcode) {
+    return ((opcode & 0xF000u) >> 4u) | (opcode & 0x00FFu);
+}
+
+/**
+ * Same decoding as instructionTable and table0/5/8/E/F,
+ * including the encodings they alias (e.g. 0x0NN0 clears the screen)
+ * @param extended: Also decode the SUPER-CHIP and XO-CHIP instructions
+ */
+constexpr Op decodeOp(std::uint16_t opcode, bool extended = false) {
+    if(extended) {
+        switch(opcode & 0xF0FFu) {
+            case 0x00FB: return Op::OP_00FB;
+            case 0x00FC: return Op::OP_00FC;
+            case 0x00FD: return Op::OP_00FD;
+            case 0x00FE: return Op::OP_00FE;
+            case 0x00FF: return Op::OP_00FF;
+            case 0xF000: return Op::OP_F000;
+            case 0xF001: return Op::OP_FN01;
+            case 0xF002: return Op::OP_F002;
+            case 0xF030: return Op::OP_FX30;
+            case 0xF03A: return Op::OP_FX3A;
+            case 0xF075: return Op::OP_FX75;
+            case 0xF085: return Op::OP_FX85;
+            default: break;
+        }
+        switch(opcode & 0xF0F0u) {
+            case 0x00C0: return Op::OP_00CN;
+            case 0x00D0: return Op::OP_00DN;
+            default: break;
+        }
+        switch(opcode & 0xF00Fu) {
+            case 0x5002: return Op::OP_5XY2;
+            case 0x5003: return Op::OP_5XY3;
+            default: break;
+        }
+    }
+
+    switch((opcode & 0xF000u) >> 12u) {
+        case 0x0:
+            switch(opcode & 0x000Fu) {
+                case 0x0: return Op::OP_00E0;
+                case 0xE: return Op::OP_00EE;
+                default: return Op::OP_NULL;
+            }
+        case 0x1: return Op::OP_1NNN;
+        case 0x2: return Op::OP_2NNN;
+        case 0x3: return Op::OP_3XNN;
+        case 0x4: return Op::OP_4XNN;
+        case 0x5: return Op::OP_5XY0;
+        case 0x6: return Op::OP_6XNN;
+        case 0x7: return Op::OP_7XNN;
+        case 0x8:
+            switch(opcode & 0x000Fu) {
+                case 0x0: return Op::OP_8XY0;
+                case 0x1: return Op::OP_8XY1;
+                case 0x2: return Op::OP_8XY2;
+                case 0x3: return Op::OP_8XY3;
+                case 0x4: return Op::OP_8XY4;
+                case 0x5: return Op::OP_8XY5;
+                case 0x6: return Op::OP_8XY6;
+                case 0x7: return Op::OP_8XY7;
+                case 0xE: return Op::OP_8XYE;
+                default: return Op::OP_NULL;
+            }
+        case 0x9: return Op::OP_9XY0;
+        case 0xA: return Op::OP_ANNN;
+        case 0xB: return Op::OP_BNNN;
+        case 0xC: return Op::OP_CXNN;
+        case 0xD: return Op::OP_DXYN;
+        case 0xE:
+            switch(opcode & 0x000Fu) {
+                case 0xE: return Op::OP_EX9E;
+                case 0x1: return Op::OP_EXA1;
+                default: return Op::OP_NULL;
+            }
+        default:
+            switch(opcode & 0x00FFu) {
+                case 0x07: return Op::OP_FX07;
+                case 0x0A: return Op::OP_FX0A;
+                case 0x15: return Op::OP_FX15;
+                case 0x18: return Op::OP_FX18;
+                case 0x1E: return Op::OP_FX1E;
+                case 0x29: return Op::OP_FX29;
+                case 0x33: return Op::OP_FX33;
+                case 0x55: return Op::OP_FX55;
+                case 0x65: return Op::OP_FX65;
+                default: return Op::OP_NULL;
+            }
+    }
+}
+
+constexpr std::array<Op, 0x1000> makeOpTable(bool extended) {
+    std::array<Op, 0x1000> table{};
+    for(std::size_t i = 0; i < table.size(); i++) {
+        //rebuild a representative opcode from the first nibble and the low byte
+        table[i] = decodeOp(static_cast<std::uint16_t>(((i & 0xF00u) << 4u) | (i & 0xFFu)), extended);
+    }
+    return table;
+}
+
+//generated at compile time, shared by every instance
+inline constexpr std::array<Op, 0x1000> OP_TABLE = makeOpTable(false);
+//for the quirk profiles with the SUPER-CHIP and XO-CHIP instructions
+inline constexpr std::array<Op, 0x1000> EXTENDED_OP_TABLE = makeOpTable(true);
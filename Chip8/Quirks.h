@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+ * Compile-time behaviour of the instructions the CHIP-8 variants disagree on.
+ * Each profile is a policy type, the handlers read it with if constexpr,
+ * so every profile gets its own specialized handlers and no runtime checks
+ */
+
+//what this core has always done: shifts read VY, FX55/FX65 keep I, BNNN adds V0, sprites clip
+struct DefaultQuirks {
+    //8XY1, 8XY2 and 8XY3 clear VF
+    static constexpr bool vfReset = false;
+    //FX55 and FX65 leave I pointing past the last register
+    static constexpr bool memoryIncrement = false;
+    //8XY6 and 8XYE shift VX in place and ignore VY
+    static constexpr bool shiftVx = false;
+    //BXNN jumps to XNN + VX instead of NNN + V0
+    static constexpr bool jumpVx = false;
+    //sprites wrap around the screen edges instead of being clipped
+    static constexpr bool wrapSprites = false;
+    //the SUPER-CHIP and XO-CHIP instructions: hires mode, scrolling, 16x16 sprites, bitplanes
+    static constexpr bool extended = false;
+    //memory reachable through I, 4 KB on everything but XO-CHIP. The pc is never masked, fetches above it read zero
+    static constexpr std::uint16_t addressMask = 0x0FFF;
+};
+
+//the original COSMAC VIP interpreter
+struct CosmacQuirks : DefaultQuirks {
+    static constexpr bool vfReset = true;
+    static constexpr bool memoryIncrement = true;
+};
+
+//SUPER-CHIP 1.1 on the HP48
+struct SuperChipQuirks : DefaultQuirks {
+    static constexpr bool shiftVx = true;
+    static constexpr bool jumpVx = true;
+    static constexpr bool extended = true;
+};
+
+//XO-CHIP (Octo)
+struct XoChipQuirks : DefaultQuirks {
+    static constexpr bool memoryIncrement = true;
+    static constexpr bool wrapSprites = true;
+    static constexpr bool extended = true;
+    static constexpr std::uint16_t addressMask = 0xFFFF;
+};
+
+/**
+ * Runtime name of a policy, Chip8::setQuirks maps it to the specialized handlers
+ */
+enum class QuirkProfile : std::uint8_t {
+    Default,
+    Cosmac,
+    SuperChip,
+    XoChip
+};
+
+/**
+ * Runtime counterpart of Quirks::extended
+ */
+inline bool extendedInstructions(QuirkProfile profile) {
+    return profile == QuirkProfile::SuperChip || profile == QuirkProfile::XoChip;
+}
+
+/**
+ * Runtime counterpart of Quirks::addressMask + 1, the memory reachable through I
+ */
+inline std::size_t addressableMemory(QuirkProfile profile) {
+    return profile == QuirkProfile::XoChip ? 0x10000 : 0x1000;
+}
+
+/**
+ * @return: "default", "chip8", "schip" or "xochip"
+ */
+inline const char* quirkProfileName(QuirkProfile profile) {
+    switch(profile) {
+        case QuirkProfile::Cosmac: return "chip8";
+        case QuirkProfile::SuperChip: return "schip";
+        case QuirkProfile::XoChip: return "xochip";
+        default: return "default";
+    }
+}
+
+/**
+ * Inverse of quirkProfileName
+ * @return: false if the name is not a known profile
+ */
+inline bool parseQuirkProfile(const std::string& name, QuirkProfile& profile) {
+    for(QuirkProfile candidate : {QuirkProfile::Default, QuirkProfile::Cosmac, QuirkProfile::SuperChip, QuirkProfile::XoChip}) {
+        if(name == quirkProfileName(candidate)) {
+            profile = candidate;
+            return true;
+        }
+    }
+    return false;
+}
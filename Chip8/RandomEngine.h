@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * xorshift64* generator for CXNN.
+ * Unlike the standard engines its whole state is one public word,
+ * so save states can copy it and restored instances draw the same numbers
+ */
+struct RandomEngine {
+    typedef std::uint64_t result_type;
+
+    std::uint64_t state{};
+
+    explicit RandomEngine(std::uint64_t seedValue = 0) {
+        seed(seedValue);
+    }
+
+    void seed(std::uint64_t seedValue) {
+        //splitmix64 spreads small or similar seeds over the whole state, which must not be zero
+        std::uint64_t z = seedValue + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+        z ^= z >> 31u;
+        state = z != 0 ? z : 0x9E3779B97F4A7C15ull;
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()() {
+        state ^= state >> 12u;
+        state ^= state << 25u;
+        state ^= state >> 27u;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+};
@@ -0,0 +1,171 @@
+#include "VectorEnv.h"
+
+#include <algorithm>
+
+#include "Scheduler.h"
+
+namespace {
+    //every bit of a byte doubled, the lores rows of the extended profiles at 128 pixels
+    constexpr std::array<std::uint16_t, 256> SPREAD_BITS = [] {
+        std::array<std::uint16_t, 256> table{};
+        for(unsigned value = 0; value < 256; value++) {
+            for(unsigned bit = 0; bit < 8; bit++) {
+                if(value & (1u << bit)) table[value] |= 3u << (2 * bit);
+            }
+        }
+        return table;
+    }();
+
+    //a row word as 8 bytes, the leftmost pixel in the most significant bit of the first
+    void storeRow(std::uint64_t word, std::uint8_t* out) {
+        for(unsigned i = 0; i < 8; i++) {
+            out[i] = static_cast<std::uint8_t>(word >> (56 - 8 * i));
+        }
+    }
+}
+
+VectorEnv::VectorEnv(std::size_t count, const EnvConfig& config, unsigned threads)
+    : config(config), pool(std::max(1u, threads)) {
+    if(this->config.actionKeys.empty()) {
+        this->config.actionKeys.push_back(-1);
+        for(std::int8_t key = 0; key < 16; key++) this->config.actionKeys.push_back(key);
+    }
+
+    envs.reserve(count);
+    for(std::size_t i = 0; i < count; i++) {
+        envs.emplace_back(i);
+        envs.back().chip8.setEngine(config.engine);
+        envs.back().chip8.setQuirks(config.quirks);
+    }
+
+    //a few ranges per worker so stealing can even out environments that run longer
+    grain = std::max<std::size_t>(1, count / (pool.size() * 8));
+}
+
+std::uint8_t VectorEnv::loadRom(const std::uint8_t* data, std::size_t size) {
+    for(Env& env : envs) {
+        std::uint8_t status = env.chip8.loadRom(data, size);
+        if(status != FailStates::SUCCESS) return status;
+    }
+    return FailStates::SUCCESS;
+}
+
+void VectorEnv::reset(const std::uint64_t* seeds, const EnvBuffers& out) {
+    pool.parallelFor(envs.size(), [&](std::size_t i, unsigned) {
+        resetEnv(envs[i], seeds[i], i, out);
+    }, grain);
+}
+
+void VectorEnv::step(const std::int32_t* actions, unsigned framesPerStep, const EnvBuffers& out) {
+    pool.parallelFor(envs.size(), [&](std::size_t i, unsigned) {
+        Env& env = envs[i];
+        if(env.done) resetEnv(env, env.seed + envs.size(), i, out);
+        else stepEnv(env, actions[i], framesPerStep, i, out);
+    }, grain);
+}
+
+void VectorEnv::resetEnv(Env& env, std::uint64_t seed, std::size_t index, const EnvBuffers& out) {
+    env.chip8.reset(seed);
+    env.seed = seed;
+    env.frame = 0;
+    env.score = readScore(env.chip8);
+    env.done = false;
+
+    writeObservation(env.chip8, out.observations + index * observationSize());
+    out.rewards[index] = 0;
+    out.dones[index] = 0;
+}
+
+void VectorEnv::stepEnv(Env& env, std::int32_t action, unsigned frames, std::size_t index, const EnvBuffers& out) {
+    Chip8& chip8 = env.chip8;
+
+    //unknown actions press nothing
+    chip8.keyPad.fill(false);
+    if(action >= 0 && static_cast<std::size_t>(action) < config.actionKeys.size()) {
+        std::int8_t key = config.actionKeys[action];
+        if(key >= 0) chip8.keyPad[key & 0xF] = true;
+    }
+
+    for(unsigned i = 0; i < frames && !env.done; i++) {
+        //the instructions of one frame, the fractions carried over so none are lost
+        double perFrame = config.frequency / Scheduler::FRAME_RATE;
+        auto first = static_cast<std::uint64_t>(env.frame * perFrame);
+        auto last = static_cast<std::uint64_t>((env.frame + 1) * perFrame);
+        chip8.run(last - first);
+        chip8.tickTimers();
+        ++env.frame;
+        env.done = episodeOver(env);
+    }
+
+    std::uint32_t score = readScore(chip8);
+    writeObservation(chip8, out.observations + index * observationSize());
+    out.rewards[index] = static_cast<float>(static_cast<std::int64_t>(score) - static_cast<std::int64_t>(env.score));
+    out.dones[index] = env.done;
+    env.score = score;
+}
+
+std::uint32_t VectorEnv::readScore(const Chip8& chip8) const {
+    if(!config.hasReward) return 0;
+    //a word read like an instruction, zero where the profile has no memory
+    std::uint16_t word = chip8.fetch(config.rewardAddress);
+    return config.rewardBytes == 2 ? word : word >> 8u;
+}
+
+bool VectorEnv::episodeOver(const Env& env) const {
+    if(config.maxEpisodeFrames > 0 && env.frame >= config.maxEpisodeFrames) return true;
+    return config.hasDone && ((env.chip8.fetch(config.doneAddress) >> 8u) & config.doneMask) == config.doneValue;
+}
+
+void VectorEnv::writeObservation(const Chip8& chip8, std::uint8_t* out) const {
+    const FrameBuffer& display = chip8.display;
+
+    if(!extendedInstructions(config.quirks)) {
+        for(std::size_t y = 0; y < FrameBuffer::LORES_HEIGHT; y++) {
+            storeRow(display.planes[0].left[y], out + y * 8);
+        }
+        return;
+    }
+
+    const std::size_t rowBytes = FrameBuffer::WIDTH / 8;
+    for(std::size_t plane = 0; plane < FrameBuffer::PLANES; plane++) {
+        std::uint8_t* planeOut = out + plane * FrameBuffer::HEIGHT * rowBytes;
+        const FrameBuffer::Plane& source = display.planes[plane];
+
+        if(display.hires) {
+            for(std::size_t y = 0; y < FrameBuffer::HEIGHT; y++) {
+                storeRow(source.left[y], planeOut + y * rowBytes);
+                storeRow(source.right[y], planeOut + y * rowBytes + 8);
+            }
+            continue;
+        }
+
+        //every lores row becomes two rows of twice the width
+        for(std::size_t y = 0; y < FrameBuffer::LORES_HEIGHT; y++) {
+            std::uint8_t* row = planeOut + 2 * y * rowBytes;
+            std::uint64_t word = source.left[y];
+            for(unsigned i = 0; i < 8; i++) {
+                std::uint16_t wide = SPREAD_BITS[(word >> (56 - 8 * i)) & 0xFFu];
+                row[2 * i] = static_cast<std::uint8_t>(wide >> 8u);
+                row[2 * i + 1] = static_cast<std::uint8_t>(wide);
+            }
+            std::copy(row, row + rowBytes, row + rowBytes);
+        }
+    }
+}
+
+std::size_t VectorEnv::size() const {
+    return envs.size();
+}
+
+std::size_t VectorEnv::actionCount() const {
+    return config.actionKeys.size();
+}
+
+std::size_t VectorEnv::observationSize() const {
+    if(!extendedInstructions(config.quirks)) return FrameBuffer::LORES_WIDTH / 8 * FrameBuffer::LORES_HEIGHT;
+    return FrameBuffer::WIDTH / 8 * FrameBuffer::HEIGHT * FrameBuffer::PLANES;
+}
+
+const Chip8& VectorEnv::environment(std::size_t index) const {
+    return envs[index].chip8;
+}
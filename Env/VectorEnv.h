@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "Chip8.h"
+#include "WorkStealingPool.h"
+
+/**
+ * How a ROM is played as an environment: what the actions press,
+ * and where in memory the game keeps its score and its game over flag
+ */
+struct EnvConfig {
+    QuirkProfile quirks{QuirkProfile::Default};
+    Chip8::Engine engine{Chip8::Engine::Threaded};
+
+    //emulated instructions per second, every frame runs 1/60 of them and ticks the timers once
+    double frequency{500};
+
+    //the keypad key every action holds down for a whole step, -1 presses nothing.
+    //Empty means 17 actions: nothing, then the keys 0-F
+    std::vector<std::int8_t> actionKeys;
+
+    //the reward of a step is how much the score at rewardAddress grew,
+    //a big-endian number of rewardBytes (1 or 2) bytes
+    bool hasReward{false};
+    std::uint16_t rewardAddress{};
+    std::uint8_t rewardBytes{1};
+
+    //an episode ends once (memory[doneAddress] & doneMask) == doneValue
+    bool hasDone{false};
+    std::uint16_t doneAddress{};
+    std::uint8_t doneMask{0xFF};
+    std::uint8_t doneValue{};
+
+    //an episode also ends after this many frames, 0 never
+    std::uint32_t maxEpisodeFrames{};
+};
+
+/**
+ * Where a step writes its results, one contiguous array of each for all environments.
+ * Owned by the caller, e.g. the memory of a NumPy array or a tensor
+ */
+struct EnvBuffers {
+    //observationSize() bytes per environment
+    std::uint8_t* observations;
+    //one per environment
+    float* rewards;
+    //one per environment, 1 in the step that ended an episode
+    std::uint8_t* dones;
+};
+
+/**
+ * A batch of environments playing the same ROM, stepped together for agent training.
+ *
+ * Every environment is a Chip8 stepped a whole number of 60 Hz frames per action,
+ * the environments are spread over a WorkStealingPool and each one writes its observation,
+ * reward and done flag straight into the caller's buffers, nothing is copied afterwards.
+ *
+ * Observations are the display packed 8 pixels per byte, most significant bit leftmost, row by row:
+ * 64x32 (256 bytes) for plain CHIP-8, and for the extended profiles 128x64 per plane
+ * (2048 bytes for both planes), with lores frames scaled up 2x so the size never changes.
+ *
+ * An environment whose episode ended starts a new one at its next step, seeded with
+ * its previous seed plus the number of environments, and that step's observation is the first
+ * of the new episode. Every episode only depends on its seed and its actions.
+ */
+class VectorEnv {
+    private:
+        struct Env {
+            Chip8 chip8;
+            std::uint64_t seed{};
+            //frames since the start of the episode, the instructions of a frame follow from it
+            std::uint64_t frame{};
+            std::uint32_t score{};
+            bool done{false};
+
+            explicit Env(std::uint64_t seed) : chip8(seed), seed(seed) {}
+        };
+
+        EnvConfig config;
+        std::vector<Env> envs;
+        WorkStealingPool pool;
+        std::size_t grain;
+
+        void resetEnv(Env& env, std::uint64_t seed, std::size_t index, const EnvBuffers& out);
+        void stepEnv(Env& env, std::int32_t action, unsigned frames, std::size_t index, const EnvBuffers& out);
+        std::uint32_t readScore(const Chip8& chip8) const;
+        bool episodeOver(const Env& env) const;
+        void writeObservation(const Chip8& chip8, std::uint8_t* out) const;
+
+    public:
+        /**
+         * @param count: Number of environments
+         * @param threads: Workers stepping them, including the calling thread
+         */
+        VectorEnv(std::size_t count, const EnvConfig& config,
+                  unsigned threads = std::thread::hardware_concurrency());
+
+        VectorEnv(const VectorEnv&) = delete;
+        VectorEnv& operator=(const VectorEnv&) = delete;
+
+        /**
+         * Load the ROM into every environment, must be called before reset()
+         * @return: FailStates::SUCCESS, ROM_EMPTY or ROM_TOO_LARGE
+         */
+        std::uint8_t loadRom(const std::uint8_t* data, std::size_t size);
+
+        /**
+         * Start a new episode in every environment and write the first observations,
+         * rewards and dones are cleared
+         * @param seeds: One per environment
+         */
+        void reset(const std::uint64_t* seeds, const EnvBuffers& out);
+
+        /**
+         * Run every environment framesPerStep frames with the key of its action held down
+         * @param actions: One per environment, an index into EnvConfig::actionKeys
+         */
+        void step(const std::int32_t* actions, unsigned framesPerStep, const EnvBuffers& out);
+
+        std::size_t size() const;
+
+        std::size_t actionCount() const;
+
+        /**
+         * @return: Bytes of one environment's observation
+         */
+        std::size_t observationSize() const;
+
+        /**
+         * One environment, to inspect or save its state
+         */
+        const Chip8& environment(std::size_t index) const;
+};
@@ -6,6 +6,10 @@ struct FailStates {
     FailStates() = delete;
     ~FailStates() = delete;
 
+    const static std::uint8_t SUCCESS = 0;
     const static std::uint8_t FILE_NOT_FOUND = 1;
     const static std::uint8_t ROM_NOT_LOADED = 2;
+    //the ROM does not fit between start_address and the end of memory
+    const static std::uint8_t ROM_TOO_LARGE = 3;
+    const static std::uint8_t ROM_EMPTY = 4;
 };
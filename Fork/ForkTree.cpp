@@ -0,0 +1,343 @@
+#include "ForkTree.h"
+
+#include <algorithm>
+#include <cstring>
+
+ForkTree::ForkTree() {
+    //referenced by the tree itself, so it is never written in place or freed
+    std::array<std::uint8_t, PAGE_SIZE> zeros{};
+    zeroPage = newPage(zeros.data());
+}
+
+ForkTree::Page& ForkTree::page(std::uint32_t index) {
+    return pageChunks[index / CHUNK_SIZE][index % CHUNK_SIZE];
+}
+
+ForkTree::Table& ForkTree::table(std::uint32_t index) {
+    return tableChunks[index / CHUNK_SIZE][index % CHUNK_SIZE];
+}
+
+ForkTree::State& ForkTree::state(StateId id) {
+    return stateChunks[id / CHUNK_SIZE][id % CHUNK_SIZE];
+}
+
+ForkTree::PageKey ForkTree::pageKey(std::uint32_t index) {
+    return (PageKey(page(index).generation) << 32u) | index;
+}
+
+ForkTree::PageKey ForkTree::tableKey(std::uint32_t index) {
+    return (PageKey(table(index).generation) << 32u) | index;
+}
+
+std::uint32_t ForkTree::newPage(const std::uint8_t* bytes) {
+    std::uint32_t index;
+    if(!freePages.empty()) {
+        index = freePages.back();
+        freePages.pop_back();
+    }
+    else {
+        if(pageCount % CHUNK_SIZE == 0) pageChunks.emplace_back(new Page[CHUNK_SIZE]());
+        index = static_cast<std::uint32_t>(pageCount++);
+    }
+
+    Page& p = page(index);
+    std::memcpy(p.bytes.data(), bytes, PAGE_SIZE);
+    p.references = 1;
+    ++stats.pages;
+    return index;
+}
+
+void ForkTree::releasePage(std::uint32_t index) {
+    Page& p = page(index);
+    if(--p.references > 0) return;
+    //whoever still holds the old key must not mistake the reused page for it
+    ++p.generation;
+    freePages.push_back(index);
+    --stats.pages;
+}
+
+std::uint32_t ForkTree::newTable() {
+    std::uint32_t index;
+    if(!freeTables.empty()) {
+        index = freeTables.back();
+        freeTables.pop_back();
+    }
+    else {
+        if(tableCount % CHUNK_SIZE == 0) tableChunks.emplace_back(new Table[CHUNK_SIZE]());
+        index = static_cast<std::uint32_t>(tableCount++);
+    }
+
+    table(index).references = 1;
+    ++stats.tables;
+    return index;
+}
+
+void ForkTree::releaseTable(std::uint32_t index) {
+    Table& t = table(index);
+    if(--t.references > 0) return;
+    for(std::uint32_t pageIndex : t.pages) {
+        releasePage(pageIndex);
+    }
+    ++t.generation;
+    freeTables.push_back(index);
+    --stats.tables;
+}
+
+ForkTree::StateId ForkTree::newState() {
+    StateId id;
+    if(!freeStates.empty()) {
+        id = freeStates.back();
+        freeStates.pop_back();
+    }
+    else {
+        if(stateCount % CHUNK_SIZE == 0) stateChunks.emplace_back(new State[CHUNK_SIZE]());
+        id = static_cast<StateId>(stateCount++);
+    }
+    state(id).live = true;
+    ++stats.states;
+    return id;
+}
+
+std::uint32_t ForkTree::capturePage(const std::uint8_t* bytes) {
+    bool zero = std::all_of(bytes, bytes + PAGE_SIZE, [](std::uint8_t b) { return b == 0; });
+    if(!zero) return newPage(bytes);
+    ++page(zeroPage).references;
+    return zeroPage;
+}
+
+void ForkTree::writePage(std::uint32_t& slot, const std::uint8_t* bytes) {
+    Page& p = page(slot);
+    if(p.references == 1) {
+        std::memcpy(p.bytes.data(), bytes, PAGE_SIZE);
+        ++p.generation;
+        return;
+    }
+    --p.references;
+    slot = newPage(bytes);
+    ++stats.pagesCopied;
+}
+
+ForkTree::Table& ForkTree::ownTable(State& owner, std::size_t index) {
+    std::uint32_t shared = owner.memory[index];
+    if(table(shared).references == 1) return table(shared);
+
+    std::uint32_t copy = newTable();
+    table(copy).pages = table(shared).pages;
+    for(std::uint32_t pageIndex : table(copy).pages) {
+        ++page(pageIndex).references;
+    }
+    --table(shared).references;
+    owner.memory[index] = copy;
+    return table(copy);
+}
+
+void ForkTree::saveRegisters(const Chip8& chip8, Registers& registers) {
+    registers.registers = chip8.registers;
+    registers.vi = chip8.vi;
+    registers.pc = chip8.pc;
+    registers.stack = chip8.stack;
+    registers.sp = chip8.sp;
+    registers.delayTimer = chip8.delay_timer;
+    registers.soundTimer = chip8.sound_timer;
+    registers.cycleCount = chip8.cycleCount;
+    registers.idleCycles = chip8.idleCycles;
+    registers.opcode = chip8.opcode;
+    registers.programSize = chip8.program_size;
+    registers.romLoaded = chip8.romLoaded;
+    registers.keyPad = chip8.keyPad;
+    registers.randomState = chip8.randomEngine.state;
+    registers.hires = chip8.display.hires;
+    registers.planeMask = chip8.planeMask;
+    registers.flags = chip8.flags;
+    registers.audioPattern = chip8.audioPattern;
+    registers.pitch = chip8.pitch;
+}
+
+void ForkTree::loadRegisters(const Registers& registers, Chip8& chip8) {
+    chip8.registers = registers.registers;
+    chip8.vi = registers.vi;
+    chip8.pc = registers.pc;
+    chip8.stack = registers.stack;
+    chip8.sp = registers.sp;
+    chip8.delay_timer = registers.delayTimer;
+    chip8.sound_timer = registers.soundTimer;
+    chip8.cycleCount = registers.cycleCount;
+    chip8.idleCycles = registers.idleCycles;
+    chip8.opcode = registers.opcode;
+    chip8.program_size = registers.programSize;
+    chip8.romLoaded = registers.romLoaded;
+    chip8.keyPad = registers.keyPad;
+    chip8.randomEngine.state = registers.randomState;
+    chip8.display.hires = registers.hires;
+    chip8.planeMask = registers.planeMask;
+    chip8.flags = registers.flags;
+    chip8.audioPattern = registers.audioPattern;
+    chip8.pitch = registers.pitch;
+}
+
+ForkTree::StateId ForkTree::capture(const Chip8& chip8) {
+    StateId id = newState();
+    State& root = state(id);
+    saveRegisters(chip8, root.registers);
+
+    for(std::size_t t = 0; t < MEMORY_TABLES; t++) {
+        root.memory[t] = newTable();
+        for(std::size_t i = 0; i < TABLE_PAGES; i++) {
+            std::size_t p = t * TABLE_PAGES + i;
+            //above the memory of the profile the address space reads as zero
+            if(p * PAGE_SIZE >= chip8.memory.size()) {
+                ++page(zeroPage).references;
+                table(root.memory[t]).pages[i] = zeroPage;
+                continue;
+            }
+            table(root.memory[t]).pages[i] = capturePage(&chip8.memory[p * PAGE_SIZE]);
+        }
+    }
+
+    const auto* display = reinterpret_cast<const std::uint8_t*>(chip8.display.planes.data());
+    for(std::size_t d = 0; d < DISPLAY_PAGES; d++) {
+        root.display[d] = capturePage(display + d * PAGE_SIZE);
+    }
+    return id;
+}
+
+ForkTree::StateId ForkTree::fork(StateId parent) {
+    StateId id = newState();
+    State& child = state(id);
+    const State& source = state(parent);
+
+    child.registers = source.registers;
+    child.memory = source.memory;
+    child.display = source.display;
+    for(std::uint32_t tableIndex : child.memory) {
+        ++table(tableIndex).references;
+    }
+    for(std::uint32_t pageIndex : child.display) {
+        ++page(pageIndex).references;
+    }
+
+    ++stats.forks;
+    return id;
+}
+
+void ForkTree::release(StateId id) {
+    State& released = state(id);
+    if(!released.live) return;
+
+    for(std::uint32_t tableIndex : released.memory) {
+        releaseTable(tableIndex);
+    }
+    for(std::uint32_t pageIndex : released.display) {
+        releasePage(pageIndex);
+    }
+    released.live = false;
+    freeStates.push_back(id);
+    --stats.states;
+}
+
+ForkStats ForkTree::getStats() const {
+    ForkStats current = stats;
+    current.bytes = current.states * sizeof(State) + current.tables * sizeof(Table) + current.pages * sizeof(Page);
+    return current;
+}
+
+void ForkTree::checkout(StateId id, ForkWorkspace& workspace) {
+    Chip8& chip8 = workspace.chip8;
+
+    //what the machine changed since the last checkout or commit no longer matches the keys
+    for(std::size_t word = 0; word < chip8.writtenPages.size(); word++) {
+        for(std::uint64_t bits = chip8.writtenPages[word]; bits != 0; bits &= bits - 1) {
+            std::size_t p = word * 64 + __builtin_ctzll(bits);
+            workspace.memoryPages[p] = INVALID_KEY;
+            workspace.memoryTables[p / TABLE_PAGES] = INVALID_KEY;
+        }
+    }
+    if(chip8.displayGeneration != workspace.displayGeneration) {
+        workspace.displayPages.fill(INVALID_KEY);
+    }
+
+    const State& source = state(id);
+    loadRegisters(source.registers, chip8);
+
+    for(std::size_t t = 0; t < MEMORY_TABLES; t++) {
+        PageKey key = tableKey(source.memory[t]);
+        if(workspace.memoryTables[t] == key) continue;
+
+        const Table& sourceTable = table(source.memory[t]);
+        for(std::size_t i = 0; i < TABLE_PAGES; i++) {
+            std::size_t p = t * TABLE_PAGES + i;
+            PageKey pageKeyNow = pageKey(sourceTable.pages[i]);
+            if(workspace.memoryPages[p] == pageKeyNow || p * PAGE_SIZE >= chip8.memory.size()) continue;
+
+            std::memcpy(&chip8.memory[p * PAGE_SIZE], page(sourceTable.pages[i]).bytes.data(), PAGE_SIZE);
+            //decoded and compiled code of the old bytes
+            chip8.invalidateCode(p * PAGE_SIZE, PAGE_SIZE);
+            workspace.memoryPages[p] = pageKeyNow;
+        }
+        workspace.memoryTables[t] = key;
+    }
+
+    auto* display = reinterpret_cast<std::uint8_t*>(chip8.display.planes.data());
+    bool displayChanged = false;
+    for(std::size_t d = 0; d < DISPLAY_PAGES; d++) {
+        PageKey key = pageKey(source.display[d]);
+        if(workspace.displayPages[d] == key) continue;
+        std::memcpy(display + d * PAGE_SIZE, page(source.display[d]).bytes.data(), PAGE_SIZE);
+        workspace.displayPages[d] = key;
+        displayChanged = true;
+    }
+    if(displayChanged) ++chip8.displayGeneration;
+
+    chip8.clearWrittenPages();
+    workspace.displayGeneration = chip8.displayGeneration;
+    workspace.state = id;
+    workspace.checkedOut = true;
+}
+
+void ForkTree::commit(ForkWorkspace& workspace) {
+    if(!workspace.checkedOut) return;
+    Chip8& chip8 = workspace.chip8;
+    State& target = state(workspace.state);
+    saveRegisters(chip8, target.registers);
+
+    for(std::size_t word = 0; word < chip8.writtenPages.size(); word++) {
+        std::uint64_t bits = chip8.writtenPages[word];
+        while(bits != 0) {
+            std::size_t p = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            std::size_t t = p / TABLE_PAGES;
+            const std::uint8_t* bytes = &chip8.memory[p * PAGE_SIZE];
+            //rewritten with the same values, e.g. FX55 of unchanged registers
+            if(std::memcmp(page(table(target.memory[t]).pages[p % TABLE_PAGES]).bytes.data(), bytes, PAGE_SIZE) == 0) {
+                continue;
+            }
+
+            Table& owned = ownTable(target, t);
+            writePage(owned.pages[p % TABLE_PAGES], bytes);
+            ++owned.generation;
+            workspace.memoryPages[p] = pageKey(owned.pages[p % TABLE_PAGES]);
+            workspace.memoryTables[t] = tableKey(target.memory[t]);
+        }
+    }
+
+    if(chip8.displayGeneration != workspace.displayGeneration) {
+        const auto* display = reinterpret_cast<const std::uint8_t*>(chip8.display.planes.data());
+        for(std::size_t d = 0; d < DISPLAY_PAGES; d++) {
+            const std::uint8_t* bytes = display + d * PAGE_SIZE;
+            if(std::memcmp(page(target.display[d]).bytes.data(), bytes, PAGE_SIZE) != 0) {
+                writePage(target.display[d], bytes);
+            }
+            workspace.displayPages[d] = pageKey(target.display[d]);
+        }
+    }
+
+    chip8.clearWrittenPages();
+    workspace.displayGeneration = chip8.displayGeneration;
+}
+
+ForkWorkspace::ForkWorkspace(const Chip8& chip8) : chip8(chip8) {
+    memoryTables.fill(ForkTree::INVALID_KEY);
+    memoryPages.fill(ForkTree::INVALID_KEY);
+    displayPages.fill(ForkTree::INVALID_KEY);
+}
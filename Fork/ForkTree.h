@@ -0,0 +1,212 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "Chip8.h"
+
+struct ForkWorkspace;
+
+struct ForkStats {
+    //states captured or forked and not released yet
+    std::size_t states{};
+    //distinct pages and page tables those states share
+    std::size_t pages{};
+    std::size_t tables{};
+    //memory of the states, their page tables and pages, filled in by getStats()
+    std::size_t bytes{};
+
+    std::uint64_t forks{};
+    //pages copied because a state wrote to a page it shared
+    std::uint64_t pagesCopied{};
+};
+
+/**
+ * Machine states for tree search, forked in O(1) instead of copying a whole Chip8.
+ *
+ * Memory and the display are split into 256 byte pages with reference counts. A state holds
+ * its registers and one page table per 4 KB of memory, tables and pages are shared between
+ * a state and its forks until one of them writes to them, then only the written page is copied.
+ * All zero pages, most of the 64 KB, are one shared page from the start.
+ *
+ * States are run on a ForkWorkspace: checkout() loads a state into it, copying only the pages
+ * that differ from the ones it already holds, and commit() stores the result back,
+ * copying only the pages the ROM wrote (Chip8::writtenPages) and the display pages that changed.
+ *
+ *     ForkTree::StateId child = tree.fork(parent);
+ *     tree.checkout(child, workspace);
+ *     workspace.chip8.run(cycles);
+ *     tree.commit(workspace);
+ *
+ * States live until release(), a workspace must be checked out again after its state was released.
+ */
+class ForkTree {
+    public:
+        typedef std::uint32_t StateId;
+
+        const static std::size_t PAGE_SIZE = Chip8::PAGE_SIZE;
+        const static std::size_t MEMORY_PAGES = Chip8::MEMORY_SIZE / PAGE_SIZE;
+        //pages of one page table
+        const static std::size_t TABLE_PAGES = 16;
+        const static std::size_t MEMORY_TABLES = MEMORY_PAGES / TABLE_PAGES;
+        //the display is 2 planes of 128 x 64 bits
+        const static std::size_t DISPLAY_PAGES = sizeof(FrameBuffer::planes) / PAGE_SIZE;
+
+        //identity of a page's or a table's content, index and generation, changes whenever the content does
+        typedef std::uint64_t PageKey;
+        constexpr static PageKey INVALID_KEY = ~PageKey(0);
+
+    private:
+        struct Page {
+            std::array<std::uint8_t, PAGE_SIZE> bytes;
+            std::uint32_t references;
+            std::uint32_t generation;
+        };
+
+        //changing any page reachable through a table also changes the table's generation,
+        //so a workspace holding the table's key holds all of its pages
+        struct Table {
+            std::array<std::uint32_t, TABLE_PAGES> pages;
+            std::uint32_t references;
+            std::uint32_t generation;
+        };
+
+        /**
+         * Everything of a save state except memory and the display planes
+         */
+        struct Registers {
+            std::array<std::uint8_t, 16> registers;
+            std::uint16_t vi;
+            std::uint16_t pc;
+            std::array<std::uint16_t, 16> stack;
+            std::uint8_t sp;
+            std::uint8_t delayTimer;
+            std::uint8_t soundTimer;
+            std::uint64_t cycleCount;
+            std::uint64_t idleCycles;
+            std::uint16_t opcode;
+            std::uint16_t programSize;
+            bool romLoaded;
+            std::array<bool, 16> keyPad;
+            std::uint64_t randomState;
+            bool hires;
+            std::uint8_t planeMask;
+            std::array<std::uint8_t, 16> flags;
+            std::array<std::uint8_t, 16> audioPattern;
+            std::uint8_t pitch;
+        };
+
+        struct State {
+            Registers registers;
+            std::array<std::uint32_t, MEMORY_TABLES> memory;
+            std::array<std::uint32_t, DISPLAY_PAGES> display;
+            bool live;
+        };
+
+        //pages, tables and states are allocated in chunks that never move
+        const static std::size_t CHUNK_SIZE = 4096;
+
+        std::vector<std::unique_ptr<Page[]>> pageChunks;
+        std::vector<std::uint32_t> freePages;
+        std::size_t pageCount{};
+
+        std::vector<std::unique_ptr<Table[]>> tableChunks;
+        std::vector<std::uint32_t> freeTables;
+        std::size_t tableCount{};
+
+        std::vector<std::unique_ptr<State[]>> stateChunks;
+        std::vector<StateId> freeStates;
+        std::size_t stateCount{};
+
+        std::uint32_t zeroPage;
+        ForkStats stats;
+
+        Page& page(std::uint32_t index);
+        Table& table(std::uint32_t index);
+        State& state(StateId id);
+        PageKey pageKey(std::uint32_t index);
+        PageKey tableKey(std::uint32_t index);
+
+        static void saveRegisters(const Chip8& chip8, Registers& registers);
+        static void loadRegisters(const Registers& registers, Chip8& chip8);
+
+        std::uint32_t newPage(const std::uint8_t* bytes);
+        void releasePage(std::uint32_t index);
+        std::uint32_t newTable();
+        void releaseTable(std::uint32_t index);
+        StateId newState();
+
+        /**
+         * A page holding bytes, the shared zero page if they are all zero
+         */
+        std::uint32_t capturePage(const std::uint8_t* bytes);
+
+        /**
+         * Replace a page with bytes, in place when nothing else references it
+         * @param slot: The page index in a table, or in the display pages of a state
+         */
+        void writePage(std::uint32_t& slot, const std::uint8_t* bytes);
+
+        /**
+         * The table of a state's memory, copied first if other states share it
+         */
+        Table& ownTable(State& owner, std::size_t index);
+
+    public:
+        ForkTree();
+
+        ForkTree(const ForkTree&) = delete;
+        ForkTree& operator=(const ForkTree&) = delete;
+
+        /**
+         * A new root state, a copy of chip8
+         */
+        StateId capture(const Chip8& chip8);
+
+        /**
+         * A new state identical to parent, sharing all its pages
+         */
+        StateId fork(StateId parent);
+
+        /**
+         * Drop a state, its pages are freed once no other state references them
+         */
+        void release(StateId state);
+
+        ForkStats getStats() const;
+
+        /**
+         * Load a state into the workspace's machine
+         */
+        void checkout(StateId state, ForkWorkspace& workspace);
+
+        /**
+         * Store the workspace's machine into the state it has checked out
+         */
+        void commit(ForkWorkspace& workspace);
+};
+
+/**
+ * A Chip8 that runs the states of a ForkTree, with the keys of the pages it holds
+ * so checking out a related state only copies the pages that differ
+ */
+struct ForkWorkspace {
+    Chip8 chip8;
+
+    ForkTree::StateId state{};
+    bool checkedOut{false};
+
+    //keys of what the machine holds, INVALID_KEY where it may hold anything
+    std::array<ForkTree::PageKey, ForkTree::MEMORY_TABLES> memoryTables;
+    std::array<ForkTree::PageKey, ForkTree::MEMORY_PAGES> memoryPages;
+    std::array<ForkTree::PageKey, ForkTree::DISPLAY_PAGES> displayPages;
+    //Chip8::displayGeneration at checkout, the display is only compared when it moved
+    std::uint32_t displayGeneration{};
+
+    /**
+     * @param chip8: Engine, quirks and idle skipping are kept, the state comes from checkout()
+     */
+    explicit ForkWorkspace(const Chip8& chip8);
+};
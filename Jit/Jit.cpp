@@ -0,0 +1,586 @@
+#include "Jit.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+//profiling builds count every instruction in the interpreter, native code would bypass the counters
+#if defined(__x86_64__) && defined(__unix__) && !defined(CHIP8_PROFILE)
+#define CHIP8_JIT_X64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    //x86-64 condition codes
+    const std::uint8_t CC_C = 0x2;
+    const std::uint8_t CC_E = 0x4;
+    const std::uint8_t CC_NE = 0x5;
+    const std::uint8_t CC_A = 0x7;
+    const std::uint8_t CC_L = 0xC;
+
+    //register numbers
+    const std::uint8_t EAX = 0;
+    const std::uint8_t ECX = 1;
+    const std::uint8_t EDX = 2;
+
+    /**
+     * Appends machine code for a block that will be copied to origin.
+     * Every memory operand is [rbx + disp32], rbx holding the Chip8 pointer
+     */
+    struct Emitter {
+        std::vector<std::uint8_t> bytes;
+        std::uintptr_t origin;
+
+        explicit Emitter(std::uintptr_t origin) : origin(origin) {}
+
+        void byte(std::uint8_t b) { bytes.push_back(b); }
+
+        void bytes16(std::uint16_t v) {
+            byte(v & 0xFFu);
+            byte(v >> 8u);
+        }
+
+        void bytes32(std::uint32_t v) {
+            for(int i = 0; i < 4; i++) byte((v >> (8 * i)) & 0xFFu);
+        }
+
+        void bytes64(std::uint64_t v) {
+            for(int i = 0; i < 8; i++) byte((v >> (8 * i)) & 0xFFu);
+        }
+
+        //ModRM for [rbx + disp32] followed by the displacement
+        void rbxDisp(std::uint8_t reg, std::int32_t disp) {
+            byte(0x80u | (reg << 3u) | 0x3u);
+            bytes32(disp);
+        }
+
+        //ModRM + SIB for [rbx + rax * scale + disp32]
+        void rbxRaxDisp(std::uint8_t reg, std::uint8_t scaleBits, std::int32_t disp) {
+            byte(0x84u | (reg << 3u));
+            byte((scaleBits << 6u) | 0x03u);
+            bytes32(disp);
+        }
+
+        //movzx reg32, byte [rbx + disp]
+        void loadByte(std::uint8_t reg, std::int32_t disp) {
+            byte(0x0F); byte(0xB6); rbxDisp(reg, disp);
+        }
+
+        //mov byte [rbx + disp], reg8
+        void storeByte(std::int32_t disp, std::uint8_t reg) {
+            byte(0x88); rbxDisp(reg, disp);
+        }
+
+        //mov word [rbx + disp], reg16
+        void storeWord(std::int32_t disp, std::uint8_t reg) {
+            byte(0x66); byte(0x89); rbxDisp(reg, disp);
+        }
+
+        //mov byte [rbx + disp], imm8
+        void storeByteImm(std::int32_t disp, std::uint8_t value) {
+            byte(0xC6); rbxDisp(0, disp); byte(value);
+        }
+
+        //mov word [rbx + disp], imm16
+        void storeWordImm(std::int32_t disp, std::uint16_t value) {
+            byte(0x66); byte(0xC7); rbxDisp(0, disp); bytes16(value);
+        }
+
+        //8-bit alu op reg8, byte [rbx + disp], op is the "r, r/m" opcode
+        void aluLoad(std::uint8_t op, std::uint8_t reg, std::int32_t disp) {
+            byte(op); rbxDisp(reg, disp);
+        }
+
+        //mov reg32, imm32
+        void movImm(std::uint8_t reg, std::uint32_t value) {
+            byte(0xB8u + reg); bytes32(value);
+        }
+
+        //cmovcc dst32, src32
+        void cmov(std::uint8_t cc, std::uint8_t dst, std::uint8_t src) {
+            byte(0x0F); byte(0x40u + cc); byte(0xC0u | (dst << 3u) | src);
+        }
+
+        //setcc reg8
+        void setcc(std::uint8_t cc, std::uint8_t reg) {
+            byte(0x0F); byte(0x90u + cc); byte(0xC0u | reg);
+        }
+
+        void jmp(const void* target) {
+            byte(0xE9); rel32(target);
+        }
+
+        void jcc(std::uint8_t cc, const void* target) {
+            byte(0x0F); byte(0x80u + cc); rel32(target);
+        }
+
+        //jcc to code emitted later, returns the displacement to pass to bind()
+        std::size_t jccForward(std::uint8_t cc) {
+            byte(0x0F); byte(0x80u + cc);
+            std::size_t at = bytes.size();
+            bytes32(0);
+            return at;
+        }
+
+        //point a forward jump at the next emitted byte
+        void bind(std::size_t at) {
+            std::uint32_t displacement = static_cast<std::uint32_t>(bytes.size() - (at + 4));
+            for(int i = 0; i < 4; i++) bytes[at + i] = (displacement >> (8 * i)) & 0xFFu;
+        }
+
+        void rel32(const void* target) {
+            std::uintptr_t next = origin + bytes.size() + 4;
+            bytes32(static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(target) - next));
+        }
+    };
+
+}
+
+Jit::Jit(Chip8& chip8, std::size_t cacheSize) : chip8(chip8), codeSize(cacheSize), blockTable(0x10000, nullptr), invalidations(0x10000, 0), entries(0x10000, 0) {
+    auto offset = [&](const void* field) {
+        return static_cast<std::int32_t>(
+                reinterpret_cast<const char*>(field) - reinterpret_cast<const char*>(&chip8)
+        );
+    };
+    registersOffset = offset(chip8.registers.data());
+    viOffset = offset(&chip8.vi);
+    pcOffset = offset(&chip8.pc);
+    stackOffset = offset(chip8.stack.data());
+    spOffset = offset(&chip8.sp);
+    delayTimerOffset = offset(&chip8.delay_timer);
+    soundTimerOffset = offset(&chip8.sound_timer);
+    keyPadOffset = offset(chip8.keyPad.data());
+
+    context.blockTable = blockTable.data();
+
+#ifdef CHIP8_JIT_X64
+    void* memory = mmap(nullptr, codeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory != MAP_FAILED) {
+        code = static_cast<std::uint8_t*>(memory);
+        emitRuntime();
+    }
+#endif
+}
+
+Jit::~Jit() {
+#ifdef CHIP8_JIT_X64
+    if(code != nullptr) munmap(code, codeSize);
+#endif
+}
+
+bool Jit::supported() {
+#ifdef CHIP8_JIT_X64
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Jit::setWritable([[maybe_unused]] std::size_t offset, [[maybe_unused]] std::size_t size, [[maybe_unused]] bool writable) {
+#ifdef CHIP8_JIT_X64
+    //never writable and executable at the same time, only the pages of the range change
+    //so a new block costs a few pages instead of the whole cache
+    std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t begin = offset / pageSize * pageSize;
+    mprotect(code + begin, offset + size - begin, writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC);
+#endif
+}
+
+void Jit::emitRuntime() {
+    Emitter e(reinterpret_cast<std::uintptr_t>(code));
+
+    //entry(chip8 = rdi, context = rsi, block = rdx)
+    //four pushes and 8 bytes keep the stack 16-byte aligned for the helper calls
+    e.byte(0x53);                                   //push rbx
+    e.byte(0x55);                                   //push rbp
+    e.byte(0x41); e.byte(0x54);                     //push r12
+    e.byte(0x41); e.byte(0x55);                     //push r13
+    e.byte(0x48); e.byte(0x83); e.byte(0xEC); e.byte(0x08);    //sub rsp, 8
+    e.byte(0x48); e.byte(0x89); e.byte(0xFB);       //mov rbx, rdi
+    e.byte(0x48); e.byte(0x89); e.byte(0xF5);       //mov rbp, rsi
+    e.byte(0x4C); e.byte(0x8B); e.byte(0x26);       //mov r12, [rsi]
+    e.byte(0x4C); e.byte(0x8B); e.byte(0x6E); e.byte(0x08);    //mov r13, [rsi + 8]
+    e.byte(0xFF); e.byte(0xE2);                     //jmp rdx
+
+    //the budget is counted down in r13 and stored back on the way out
+    std::size_t exitOffset = e.bytes.size();
+    e.byte(0x4C); e.byte(0x89); e.byte(0x6D); e.byte(0x08);    //mov [rbp + 8], r13
+    e.byte(0x48); e.byte(0x83); e.byte(0xC4); e.byte(0x08);    //add rsp, 8
+    e.byte(0x41); e.byte(0x5D);                     //pop r13
+    e.byte(0x41); e.byte(0x5C);                     //pop r12
+    e.byte(0x5D);                                   //pop rbp
+    e.byte(0x5B);                                   //pop rbx
+    e.byte(0xC3);                                   //ret
+
+    std::memcpy(code, e.bytes.data(), e.bytes.size());
+    codeUsed = runtimeSize = e.bytes.size();
+    entry = reinterpret_cast<EntryFunc>(code);
+    exitStub = code + exitOffset;
+    setWritable(0, codeSize, false);
+}
+
+void Jit::interpret(Chip8* chip8, std::uint32_t opcode) {
+    chip8->opcode = opcode;
+    chip8->executeInstruction();
+}
+
+void* Jit::compileBlock(std::uint16_t address) {
+    std::uint8_t* origin = code + codeUsed;
+    Emitter e(reinterpret_cast<std::uintptr_t>(origin));
+
+    auto reg = [&](std::uint8_t x) { return registersOffset + x; };
+    const std::int32_t VF = registersOffset + 0xF;
+
+    auto callInterpreter = [&](std::uint16_t opcode) {
+        e.byte(0x48); e.byte(0x89); e.byte(0xDF);       //mov rdi, rbx
+        e.byte(0xBE); e.bytes32(opcode);                //mov esi, opcode
+        e.byte(0x48); e.byte(0xB8);                     //mov rax, interpret
+        e.bytes64(reinterpret_cast<std::uint64_t>(&Jit::interpret));
+        e.byte(0xFF); e.byte(0xD0);                     //call rax
+    };
+
+    //pc = condition ? skip : next, flags already set
+    auto conditionalSkip = [&](std::uint8_t cc, std::uint16_t next) {
+        e.movImm(EAX, next);
+        e.movImm(ECX, next + 2);
+        e.cmov(cc, EAX, ECX);
+        e.storeWord(pcOffset, EAX);
+    };
+
+    //where the budget ran out before an instruction, and the instruction's address
+    struct Stop {
+        std::size_t jump;
+        std::uint16_t pc;
+    };
+    std::vector<Stop> stops;
+    //code offset of every instruction, each one is an entry point
+    std::vector<std::size_t> entryOffsets;
+
+    std::uint32_t addr = address;
+    unsigned length = 0;
+    bool pcStored = false;
+    bool forceExit = false;
+
+    //blocks end at the end of memory, run() never compiles one at the last byte so none is empty
+    while(length < MAX_BLOCK_LENGTH && addr + 2u <= chip8.memory.size()) {
+        std::uint16_t opcode = (chip8.memory[addr] << 8u) | chip8.memory[addr + 1];
+        Chip8::Operands a = Chip8::splitOperands(opcode);
+        std::uint16_t next = addr + 2;
+        bool terminator = false;
+
+        //every instruction charges itself, so the block can be entered at any of them and stop before any of them
+        entryOffsets.push_back(e.bytes.size());
+        e.byte(0x49); e.byte(0x83); e.byte(0xED); e.byte(0x01);    //sub r13, 1
+        stops.push_back({e.jccForward(CC_L), static_cast<std::uint16_t>(addr)});
+
+        //classify by the handler the interpreter would run, so both agree on every encoding
+        Chip8::Chip8Func h = chip8.decode(opcode).handler;
+        //native code has the default semantics of the instructions the quirk profiles change
+        Op op = OP_TABLE[opTableIndex(opcode)];
+        bool quirky = chip8.quirks != QuirkProfile::Default &&
+                      (op == Op::OP_8XY1 || op == Op::OP_8XY2 || op == Op::OP_8XY3 ||
+                       op == Op::OP_8XY6 || op == Op::OP_8XYE || op == Op::OP_BNNN);
+
+        if(quirky) {
+            callInterpreter(opcode);
+            //BNNN has set pc itself
+            pcStored = terminator = op == Op::OP_BNNN;
+        }
+        else if(h == &Chip8::OP_00EE) {
+            e.byte(0xFE); e.rbxDisp(1, spOffset);                       //dec byte [sp]
+            e.loadByte(EAX, spOffset);
+            e.byte(0x83); e.byte(0xE0); e.byte(0x0F);                   //and eax, 0xF
+            e.byte(0x0F); e.byte(0xB7); e.rbxRaxDisp(ECX, 1, stackOffset); //movzx ecx, word [stack + sp * 2]
+            e.storeWord(pcOffset, ECX);
+            pcStored = terminator = true;
+        }
+        else if(h == &Chip8::OP_1NNN) {
+            e.storeWordImm(pcOffset, a.nnn);
+            pcStored = terminator = true;
+        }
+        else if(h == &Chip8::OP_2NNN) {
+            e.loadByte(EAX, spOffset);
+            e.byte(0x83); e.byte(0xE0); e.byte(0x0F);                   //and eax, 0xF
+            e.byte(0x66); e.byte(0xC7); e.rbxRaxDisp(0, 1, stackOffset); e.bytes16(next); //stack[sp] = next
+            e.byte(0xFE); e.rbxDisp(0, spOffset);                       //inc byte [sp]
+            e.storeWordImm(pcOffset, a.nnn);
+            pcStored = terminator = true;
+        }
+        else if(op == Op::OP_3XNN || op == Op::OP_4XNN) {
+            e.byte(0x80); e.rbxDisp(7, reg(a.x)); e.byte(a.nn);        //cmp byte [Vx], nn
+            conditionalSkip(op == Op::OP_3XNN ? CC_E : CC_NE, next);
+            pcStored = terminator = true;
+        }
+        else if(op == Op::OP_5XY0 || op == Op::OP_9XY0) {
+            e.loadByte(EAX, reg(a.x));
+            e.aluLoad(0x3A, EAX, reg(a.y));                             //cmp al, [Vy]
+            conditionalSkip(op == Op::OP_5XY0 ? CC_E : CC_NE, next);
+            pcStored = terminator = true;
+        }
+        else if(h == &Chip8::OP_6XNN) {
+            e.storeByteImm(reg(a.x), a.nn);
+        }
+        else if(h == &Chip8::OP_7XNN) {
+            e.byte(0x80); e.rbxDisp(0, reg(a.x)); e.byte(a.nn);        //add byte [Vx], nn
+        }
+        else if(h == &Chip8::OP_8XY0) {
+            e.loadByte(EAX, reg(a.y));
+            e.storeByte(reg(a.x), EAX);
+        }
+        else if(op == Op::OP_8XY1 || op == Op::OP_8XY2 || op == Op::OP_8XY3) {
+            std::uint8_t alu = op == Op::OP_8XY1 ? 0x0A : op == Op::OP_8XY2 ? 0x22 : 0x32; //or, and, xor
+            e.loadByte(EAX, reg(a.x));
+            e.aluLoad(alu, EAX, reg(a.y));
+            e.storeByte(reg(a.x), EAX);
+        }
+        else if(h == &Chip8::OP_8XY4) {
+            e.loadByte(EAX, reg(a.x));
+            e.aluLoad(0x02, EAX, reg(a.y));                             //add al, [Vy]
+            e.setcc(CC_C, ECX);
+            e.storeByte(VF, ECX);
+            e.storeByte(reg(a.x), EAX);
+        }
+        else if(h == &Chip8::OP_8XY5 || h == &Chip8::OP_8XY7) {
+            //VF is written first and the operands reloaded, exactly like the interpreter
+            std::uint8_t minuend = h == &Chip8::OP_8XY5 ? a.x : a.y;
+            std::uint8_t subtrahend = h == &Chip8::OP_8XY5 ? a.y : a.x;
+            e.loadByte(EAX, reg(minuend));
+            e.aluLoad(0x3A, EAX, reg(subtrahend));                      //cmp al, [subtrahend]
+            e.setcc(CC_A, EDX);
+            e.storeByte(VF, EDX);
+            e.loadByte(EAX, reg(minuend));
+            e.aluLoad(0x2A, EAX, reg(subtrahend));                      //sub al, [subtrahend]
+            e.storeByte(reg(a.x), EAX);
+        }
+        else if(op == Op::OP_8XY6) {
+            e.loadByte(EAX, reg(a.y));
+            e.byte(0xD0); e.byte(0xE8);                                 //shr al, 1
+            e.storeByte(reg(a.x), EAX);
+            e.loadByte(EAX, reg(a.y));
+            e.byte(0x24); e.byte(0x01);                                 //and al, 1
+            e.storeByte(VF, EAX);
+        }
+        else if(op == Op::OP_8XYE) {
+            e.loadByte(EAX, reg(a.y));
+            e.byte(0xD0); e.byte(0xE0);                                 //shl al, 1
+            e.storeByte(reg(a.x), EAX);
+            e.loadByte(EAX, reg(a.y));
+            e.byte(0xC0); e.byte(0xE8); e.byte(7);                      //shr al, 7
+            e.storeByte(VF, EAX);
+        }
+        else if(h == &Chip8::OP_ANNN) {
+            e.storeWordImm(viOffset, a.nnn);
+        }
+        else if(op == Op::OP_BNNN) {
+            e.loadByte(EAX, reg(0));
+            e.byte(0x05); e.bytes32(a.nnn);                             //add eax, nnn
+            e.storeWord(pcOffset, EAX);
+            pcStored = terminator = true;
+        }
+        else if(op == Op::OP_EX9E || op == Op::OP_EXA1) {
+            e.loadByte(EAX, reg(a.x));
+            e.byte(0x83); e.byte(0xE0); e.byte(0x0F);                   //and eax, 0xF
+            e.byte(0x80); e.rbxRaxDisp(7, 0, keyPadOffset); e.byte(0);  //cmp byte [keyPad + (Vx & 0xF)], 0
+            conditionalSkip(op == Op::OP_EX9E ? CC_NE : CC_E, next);
+            pcStored = terminator = true;
+        }
+        else if(h == &Chip8::OP_FX07) {
+            e.loadByte(EAX, delayTimerOffset);
+            e.storeByte(reg(a.x), EAX);
+        }
+        else if(h == &Chip8::OP_FX15 || h == &Chip8::OP_FX18) {
+            e.loadByte(EAX, reg(a.x));
+            e.storeByte(h == &Chip8::OP_FX15 ? delayTimerOffset : soundTimerOffset, EAX);
+        }
+        else if(h == &Chip8::OP_FX1E) {
+            e.loadByte(EAX, reg(a.x));
+            e.byte(0x66); e.byte(0x01); e.rbxDisp(EAX, viOffset);       //add word [vi], ax
+        }
+        else if(h == &Chip8::OP_FX29) {
+            e.loadByte(EAX, reg(a.x));
+            e.byte(0x8D); e.byte(0x04); e.byte(0x80);                   //lea eax, [rax + rax * 4]
+            e.byte(0x05); e.bytes32(Chip8::fontset_start_address);      //add eax, font
+            e.storeWord(viOffset, EAX);
+        }
+        else if(h == &Chip8::OP_FX0A || op == Op::OP_FX33 || op == Op::OP_FX55) {
+            //may rewind pc or overwrite code, hand control back to the driver
+            e.storeWordImm(pcOffset, next);
+            callInterpreter(opcode);
+            pcStored = terminator = forceExit = true;
+        }
+        else if(h != &Chip8::OP_NULL) {
+            //00E0, CXNN, DXYN and FX65 run on the interpreter
+            callInterpreter(opcode);
+        }
+
+        ++length;
+        addr += 2;
+        if(terminator) break;
+    }
+
+    if(!pcStored) e.storeWordImm(pcOffset, static_cast<std::uint16_t>(addr));
+
+    if(forceExit) {
+        e.jmp(exitStub);
+    }
+    else {
+        //chain into the next block, which checks the budget itself
+        e.byte(0x0F); e.byte(0xB7); e.rbxDisp(EAX, pcOffset);   //movzx eax, word [pc]
+        e.byte(0x49); e.byte(0x8B); e.byte(0x04); e.byte(0xC4); //mov rax, [r12 + rax * 8]
+        e.byte(0x48); e.byte(0x85); e.byte(0xC0);               //test rax, rax
+        e.jcc(CC_E, exitStub);
+        e.byte(0xFF); e.byte(0xE0);                             //jmp rax
+    }
+
+    //out of budget: pc at the instruction that did not run, its charge given back
+    for(const Stop& stop : stops) {
+        e.bind(stop.jump);
+        e.byte(0x49); e.byte(0x83); e.byte(0xC5); e.byte(0x01);    //add r13, 1
+        e.storeWordImm(pcOffset, stop.pc);
+        e.jmp(exitStub);
+    }
+
+    if(codeUsed + e.bytes.size() > codeSize) return nullptr;
+
+    setWritable(codeUsed, e.bytes.size(), true);
+    std::memcpy(origin, e.bytes.data(), e.bytes.size());
+    setWritable(codeUsed, e.bytes.size(), false);
+
+    Block block{address, addr, codeUsed, codeUsed + e.bytes.size()};
+    codeUsed += e.bytes.size();
+
+    //entry points of the following instructions that no other block has taken yet
+    blockTable[address] = origin;
+    for(unsigned k = 1; k < length; k++) {
+        void*& slot = blockTable[address + 2 * k];
+        if(slot == nullptr) slot = origin + entryOffsets[k];
+    }
+    blocks.push_back(block);
+    ++stats.blocksCompiled;
+    return origin;
+}
+
+void Jit::unlink(const Block& block) {
+    const std::uint8_t* begin = code + block.codeBegin;
+    const std::uint8_t* end = code + block.codeEnd;
+    for(std::uint32_t address = block.begin; address < block.end; address += 2) {
+        auto* target = static_cast<const std::uint8_t*>(blockTable[address]);
+        if(target >= begin && target < end) blockTable[address] = nullptr;
+    }
+}
+
+void Jit::checkCodeWrites() {
+    if(chip8.codeWriteBegin >= chip8.codeWriteEnd) return;
+
+    std::uint16_t begin = chip8.codeWriteBegin;
+    std::uint16_t end = chip8.codeWriteEnd;
+    chip8.clearCodeWrites();
+
+    for(std::size_t i = 0; i < blocks.size();) {
+        if(blocks[i].begin < end && begin < blocks[i].end) {
+            unlink(blocks[i]);
+            if(invalidations[blocks[i].begin] < MAX_INVALIDATIONS) ++invalidations[blocks[i].begin];
+            blocks[i] = blocks.back();
+            blocks.pop_back();
+            ++stats.blocksInvalidated;
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+void Jit::flush() {
+    for(const Block& block : blocks) {
+        unlink(block);
+    }
+    blocks.clear();
+    std::fill(invalidations.begin(), invalidations.end(), 0);
+    chip8.clearCodeWrites();
+    if(code != nullptr) {
+        //keep the entry and exit stubs at the start of the cache
+        codeUsed = runtimeSize;
+    }
+    ++stats.cacheFlushes;
+}
+
+void Jit::run(std::uint64_t cycles) {
+    std::unique_ptr<Chip8> shadow;
+    if(verify) shadow = std::make_unique<Chip8>(chip8);
+
+    //the SUPER-CHIP and XO-CHIP instructions have no native translation, those profiles interpret
+    bool native = code != nullptr && !extendedInstructions(chip8.quirks);
+
+    context.remaining = cycles;
+    while(context.remaining > 0) {
+        //idle loops are fast-forwarded before they are entered, native code would spin through them
+        std::uint64_t remaining = context.remaining;
+        if(chip8.skipIdle(remaining)) {
+            chip8.cycleCount += context.remaining - remaining;
+            if(shadow) {
+                std::uint64_t shadowRemaining = context.remaining;
+                shadow->skipIdle(shadowRemaining);
+            }
+            context.remaining = remaining;
+            continue;
+        }
+
+        //an instruction at the last byte of memory wraps around to address 0, the interpreter fetches it
+        bool compilable = native && chip8.pc + 2u <= chip8.memory.size();
+        void* block = compilable ? blockTable[chip8.pc] : nullptr;
+        if(block == nullptr && compilable && invalidations[chip8.pc] < MAX_INVALIDATIONS) {
+            //code that runs once, e.g. a slide through zero memory, is not worth compiling
+            if(entries[chip8.pc] < HOT_ENTRIES) {
+                ++entries[chip8.pc];
+            }
+            else {
+                block = compileBlock(chip8.pc);
+                if(block == nullptr) {
+                    flush();
+                    block = compileBlock(chip8.pc);
+                }
+            }
+        }
+
+        std::int64_t before = context.remaining;
+        std::uint16_t blockPc = chip8.pc;
+        if(block != nullptr) {
+            entry(&chip8, &context, block);
+        }
+
+        if(context.remaining == before) {
+            //nothing compiled for this address
+            chip8.cycle();
+            --context.remaining;
+            ++stats.interpretedInstructions;
+        }
+        else {
+            stats.nativeInstructions += before - context.remaining;
+            chip8.cycleCount += before - context.remaining;
+        }
+
+        checkCodeWrites();
+
+        if(verify) {
+            for(std::int64_t i = 0; i < before - context.remaining; i++) {
+                shadow->cycle();
+            }
+            if(shadow->registersHash() != chip8.registersHash() ||
+               shadow->memoryHash() != chip8.memoryHash() ||
+               shadow->displayHash() != chip8.displayHash()) {
+                if(stats.mismatches++ == 0) stats.firstMismatchPc = blockPc;
+                shadow = std::make_unique<Chip8>(chip8);
+            }
+        }
+    }
+}
+
+void Jit::setVerify(bool enabled) {
+    verify = enabled;
+}
+
+const JitStats& Jit::getStats() const {
+    return stats;
+}
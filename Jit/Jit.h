@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "Chip8.h"
+
+/**
+ * Budget shared between the driver and the native code,
+ * the layout is hardcoded in the emitted instructions
+ */
+struct JitContext {
+    //one native entry point per address, nullptr if not compiled
+    void* const* blockTable;
+    //instructions left, native code counts it down in a register and stores it back when it exits
+    std::int64_t remaining;
+};
+
+struct JitStats {
+    std::uint64_t blocksCompiled{};
+    std::uint64_t blocksInvalidated{};
+    std::uint64_t cacheFlushes{};
+    std::uint64_t nativeInstructions{};
+    std::uint64_t interpretedInstructions{};
+
+    //set by the verifying run, blocks whose result differed from the interpreter
+    std::uint64_t mismatches{};
+    std::uint16_t firstMismatchPc{};
+};
+
+/**
+ * x86-64 dynamic recompiler for a single Chip8 instance.
+ *
+ * Basic blocks end at jumps, calls, returns and skips, and are compiled
+ * to native code in an executable code cache. Blocks chain into each other
+ * through blockTable, so tight loops never leave native code while there is budget.
+ * Every instruction charges the budget itself, so a block stops exactly where the budget ends
+ * and the next call enters it again at that instruction, like AotRunner does with its entries.
+ * Short slices like the batch runner's frames still execute natively.
+ * Instructions with no native translation call back into the interpreter.
+ * Writes through FX33/FX55 end the block and drop every block they overlap.
+ * Under a quirk profile other than the default, the instructions it changes call the interpreter too,
+ * and the SUPER-CHIP and XO-CHIP profiles are interpreted entirely.
+ *
+ * On hosts other than x86-64, and in profiling builds, the JIT is not supported and run() interprets.
+ */
+class Jit {
+    private:
+        //longest block in instructions
+        const static unsigned MAX_BLOCK_LENGTH = 64;
+
+        //addresses invalidated this often are left to the interpreter,
+        //recompiling code that rewrites itself every iteration costs more than it saves
+        const static std::uint8_t MAX_INVALIDATIONS = 8;
+
+        //times the driver reaches an address without a block before compiling one there
+        const static std::uint8_t HOT_ENTRIES = 2;
+
+        struct Block {
+            std::uint16_t begin;
+            //0x10000 for a block ending at the end of memory
+            std::uint32_t end;
+            //where its code lies in the cache, [codeBegin, codeEnd)
+            std::size_t codeBegin;
+            std::size_t codeEnd;
+        };
+
+        typedef void (*EntryFunc)(Chip8*, JitContext*, const void*);
+
+        Chip8& chip8;
+
+        //byte offsets of the Chip8 fields accessed by native code
+        std::int32_t registersOffset;
+        std::int32_t viOffset;
+        std::int32_t pcOffset;
+        std::int32_t stackOffset;
+        std::int32_t spOffset;
+        std::int32_t delayTimerOffset;
+        std::int32_t soundTimerOffset;
+        std::int32_t keyPadOffset;
+
+        std::uint8_t* code{nullptr};
+        std::size_t codeSize;
+        std::size_t codeUsed{};
+        std::size_t runtimeSize{};
+        EntryFunc entry{nullptr};
+        const std::uint8_t* exitStub{nullptr};
+
+        //indexed by the whole 16-bit pc range so native lookups need no bounds check,
+        //every instruction of a block is an entry point
+        std::vector<void*> blockTable;
+        std::vector<Block> blocks;
+        std::vector<std::uint8_t> invalidations;
+        std::vector<std::uint8_t> entries;
+
+        JitContext context{};
+
+        bool verify{false};
+        JitStats stats;
+
+        void emitRuntime();
+        void* compileBlock(std::uint16_t address);
+        //drop the blockTable entries that point into a block
+        void unlink(const Block& block);
+        void checkCodeWrites();
+        void setWritable(std::size_t offset, std::size_t size, bool writable);
+
+        static void interpret(Chip8* chip8, std::uint32_t opcode);
+
+    public:
+        /**
+         * @param chip8: The instance to run, must outlive the JIT
+         * @param cacheSize: Size of the executable code cache in bytes
+         */
+        explicit Jit(Chip8& chip8, std::size_t cacheSize = 4 << 20);
+        ~Jit();
+
+        Jit(const Jit&) = delete;
+        Jit& operator=(const Jit&) = delete;
+
+        /**
+         * Whether native code can be generated on this host
+         */
+        static bool supported();
+
+        /**
+         * Execute exactly the given number of instructions
+         */
+        void run(std::uint64_t cycles);
+
+        /**
+         * Drop all compiled code, needed after the memory was replaced from outside (e.g. loadRom)
+         */
+        void flush();
+
+        /**
+         * Check every block against a shadow interpreter, mismatches are counted in the stats
+         */
+        void setVerify(bool enabled);
+
+        const JitStats& getStats() const;
+};
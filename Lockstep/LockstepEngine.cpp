@@ -0,0 +1,623 @@
+#include "LockstepEngine.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CHIP8_LOCKSTEP_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+    const std::size_t BLOCK = LockstepEngine::BLOCK_SIZE;
+
+    /**
+     * Fetch like Chip8::fetch: the pc is not masked and the second byte wraps at 0xFFFF.
+     * A lane holds the 4 KB it can write through I, everything above reads as zero
+     */
+    std::uint16_t fetch(const std::uint8_t* code, std::uint16_t address) {
+        auto byte = [code](std::uint16_t at) -> std::uint16_t { return at < LockstepEngine::MEMORY_SIZE ? code[at] : 0; };
+        return (byte(address) << 8u) | byte(address + 1);
+    }
+
+    /**
+     * The registers of one block: row r holds register r of the block's 32 lanes
+     */
+    struct BlockRegisters {
+        std::uint8_t* base;
+        std::size_t stride;
+
+        std::uint8_t* row(std::uint8_t reg) const {
+            return base + reg * stride;
+        }
+    };
+
+    /**
+     * ALU instructions and skips on all lanes of a block with plain loops,
+     * in exactly the order of the Chip8 handlers so X or Y being VF behaves the same
+     * @param skips: Bit per lane that skips the next instruction
+     * @return: false if the instruction has no block implementation
+     */
+    bool executeGeneric(Op op, const Chip8::Operands& args, const BlockRegisters& block, std::uint32_t& skips) {
+        std::uint8_t* x = block.row(args.x);
+        std::uint8_t* y = block.row(args.y);
+        std::uint8_t* f = block.row(0xF);
+        skips = 0;
+
+        switch(op) {
+            case Op::OP_3XNN:
+                for(std::size_t i = 0; i < BLOCK; i++) skips |= std::uint32_t(x[i] == args.nn) << i;
+                return true;
+            case Op::OP_4XNN:
+                for(std::size_t i = 0; i < BLOCK; i++) skips |= std::uint32_t(x[i] != args.nn) << i;
+                return true;
+            case Op::OP_5XY0:
+                for(std::size_t i = 0; i < BLOCK; i++) skips |= std::uint32_t(x[i] == y[i]) << i;
+                return true;
+            case Op::OP_9XY0:
+                for(std::size_t i = 0; i < BLOCK; i++) skips |= std::uint32_t(x[i] != y[i]) << i;
+                return true;
+            case Op::OP_6XNN:
+                for(std::size_t i = 0; i < BLOCK; i++) x[i] = args.nn;
+                return true;
+            case Op::OP_7XNN:
+                for(std::size_t i = 0; i < BLOCK; i++) x[i] += args.nn;
+                return true;
+            case Op::OP_8XY0:
+                for(std::size_t i = 0; i < BLOCK; i++) x[i] = y[i];
+                return true;
+            case Op::OP_8XY1:
+                for(std::size_t i = 0; i < BLOCK; i++) x[i] |= y[i];
+                return true;
+            case Op::OP_8XY2:
+                for(std::size_t i = 0; i < BLOCK; i++) x[i] &= y[i];
+                return true;
+            case Op::OP_8XY3:
+                for(std::size_t i = 0; i < BLOCK; i++) x[i] ^= y[i];
+                return true;
+            case Op::OP_8XY4:
+                for(std::size_t i = 0; i < BLOCK; i++) {
+                    std::uint16_t result = x[i] + y[i];
+                    f[i] = result > 0xFFu;
+                    x[i] = result & 0xFFu;
+                }
+                return true;
+            case Op::OP_8XY5:
+                for(std::size_t i = 0; i < BLOCK; i++) {
+                    f[i] = x[i] > y[i];
+                    x[i] -= y[i];
+                }
+                return true;
+            case Op::OP_8XY6:
+                for(std::size_t i = 0; i < BLOCK; i++) {
+                    x[i] = y[i] >> 1u;
+                    f[i] = y[i] & 0x01u;
+                }
+                return true;
+            case Op::OP_8XY7:
+                for(std::size_t i = 0; i < BLOCK; i++) {
+                    f[i] = y[i] > x[i];
+                    x[i] = y[i] - x[i];
+                }
+                return true;
+            case Op::OP_8XYE:
+                for(std::size_t i = 0; i < BLOCK; i++) {
+                    x[i] = y[i] << 1u;
+                    f[i] = (y[i] & 0x80u) >> 7u;
+                }
+                return true;
+            default:
+                return false;
+        }
+    }
+
+#ifdef CHIP8_LOCKSTEP_AVX2
+    __attribute__((target("avx2")))
+    inline __m256i load(const std::uint8_t* row) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row));
+    }
+
+    __attribute__((target("avx2")))
+    inline void store(std::uint8_t* row, __m256i value) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row), value);
+    }
+
+    //0xFF in every lane where a > b, unsigned
+    __attribute__((target("avx2")))
+    inline __m256i greater(__m256i a, __m256i b) {
+        return _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(a, b), a), _mm256_set1_epi8(-1));
+    }
+
+    /**
+     * Same as executeGeneric, one 32 lane vector per register.
+     * Stores and loads keep the order of the handlers, so aliasing registers stay exact
+     */
+    __attribute__((target("avx2")))
+    bool executeAvx2(Op op, const Chip8::Operands& args, const BlockRegisters& block, std::uint32_t& skips) {
+        std::uint8_t* x = block.row(args.x);
+        std::uint8_t* y = block.row(args.y);
+        std::uint8_t* f = block.row(0xF);
+        const __m256i one = _mm256_set1_epi8(1);
+        const __m256i nn = _mm256_set1_epi8(static_cast<char>(args.nn));
+        skips = 0;
+
+        switch(op) {
+            case Op::OP_3XNN:
+                skips = _mm256_movemask_epi8(_mm256_cmpeq_epi8(load(x), nn));
+                return true;
+            case Op::OP_4XNN:
+                skips = ~std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load(x), nn)));
+                return true;
+            case Op::OP_5XY0:
+                skips = _mm256_movemask_epi8(_mm256_cmpeq_epi8(load(x), load(y)));
+                return true;
+            case Op::OP_9XY0:
+                skips = ~std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load(x), load(y))));
+                return true;
+            case Op::OP_6XNN:
+                store(x, nn);
+                return true;
+            case Op::OP_7XNN:
+                store(x, _mm256_add_epi8(load(x), nn));
+                return true;
+            case Op::OP_8XY0:
+                store(x, load(y));
+                return true;
+            case Op::OP_8XY1:
+                store(x, _mm256_or_si256(load(x), load(y)));
+                return true;
+            case Op::OP_8XY2:
+                store(x, _mm256_and_si256(load(x), load(y)));
+                return true;
+            case Op::OP_8XY3:
+                store(x, _mm256_xor_si256(load(x), load(y)));
+                return true;
+            case Op::OP_8XY4: {
+                __m256i a = load(x);
+                __m256i b = load(y);
+                __m256i sum = _mm256_add_epi8(a, b);
+                //carry when a > 255 - b
+                store(f, _mm256_and_si256(greater(a, _mm256_xor_si256(b, _mm256_set1_epi8(-1))), one));
+                store(x, sum);
+                return true;
+            }
+            case Op::OP_8XY5:
+                store(f, _mm256_and_si256(greater(load(x), load(y)), one));
+                store(x, _mm256_sub_epi8(load(x), load(y)));
+                return true;
+            case Op::OP_8XY6:
+                //no 8-bit shifts, shift 16-bit lanes and drop the bit from the neighbour
+                store(x, _mm256_and_si256(_mm256_srli_epi16(load(y), 1), _mm256_set1_epi8(0x7F)));
+                store(f, _mm256_and_si256(load(y), one));
+                return true;
+            case Op::OP_8XY7:
+                store(f, _mm256_and_si256(greater(load(y), load(x)), one));
+                store(x, _mm256_sub_epi8(load(y), load(x)));
+                return true;
+            case Op::OP_8XYE: {
+                __m256i b = load(y);
+                store(x, _mm256_add_epi8(b, b));
+                store(f, _mm256_and_si256(_mm256_srli_epi16(load(y), 7), one));
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+#endif
+
+}
+
+LockstepEngine::LockstepEngine(std::size_t lanes)
+        : lanes(lanes), stride((lanes + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE) {
+    registers.resize(16 * stride);
+    vi.resize(stride);
+    pc.resize(stride);
+    stack.resize(16 * stride);
+    sp.resize(stride);
+    delayTimer.resize(stride);
+    soundTimer.resize(stride);
+    keyPad.resize(16 * stride);
+    randomState.resize(stride);
+    memory.resize(stride * MEMORY_SIZE);
+    display.resize(stride * FrameBuffer::LORES_HEIGHT);
+    std::size_t blocks = stride / BLOCK_SIZE;
+    blockPc.resize(blocks);
+    blockConverged.resize(blocks, true);
+    activeLanes.resize(blocks);
+    for(std::size_t block = 0; block < blocks; block++) {
+        std::size_t active = std::min(lanes - block * BLOCK_SIZE, std::size_t(BLOCK_SIZE));
+        activeLanes[block] = active == 32 ? 0xFFFFFFFFu : (1u << active) - 1u;
+    }
+    codeWriteBegin.resize(blocks);
+    codeWriteEnd.resize(blocks);
+
+    avx2 = avx2Supported();
+
+    //every lane starts as a fresh instance
+    Chip8 fresh(0);
+    std::fill(blockPc.begin(), blockPc.end(), fresh.pc);
+    for(std::size_t lane = 0; lane < stride; lane++) {
+        pc[lane] = fresh.pc;
+        randomState[lane] = fresh.randomEngine.state;
+        std::memcpy(&memory[lane * MEMORY_SIZE], fresh.memory.data(), MEMORY_SIZE);
+    }
+    std::fill(codeWriteBegin.begin(), codeWriteBegin.end(), 0xFFFF);
+}
+
+std::size_t LockstepEngine::size() const {
+    return lanes;
+}
+
+bool LockstepEngine::avx2Supported() {
+#ifdef CHIP8_LOCKSTEP_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+void LockstepEngine::setAvx2(bool enabled) {
+    avx2 = enabled && avx2Supported();
+}
+
+bool LockstepEngine::usingAvx2() const {
+    return avx2;
+}
+
+std::uint8_t LockstepEngine::loadRom(const std::uint8_t* data, std::size_t size) {
+    //one fresh instance validates and lays out the ROM, every lane copies it
+    //lanes only have the 4 KB of plain CHIP-8
+    if(size > MEMORY_SIZE - Chip8::start_address) return FailStates::ROM_TOO_LARGE;
+    Chip8 fresh(0);
+    std::uint8_t status = fresh.loadRom(data, size);
+    if(status != FailStates::SUCCESS) return status;
+
+    std::fill(registers.begin(), registers.end(), 0);
+    std::fill(stack.begin(), stack.end(), 0);
+    std::fill(sp.begin(), sp.end(), 0);
+    std::fill(vi.begin(), vi.end(), 0);
+    std::fill(delayTimer.begin(), delayTimer.end(), 0);
+    std::fill(soundTimer.begin(), soundTimer.end(), 0);
+    std::fill(keyPad.begin(), keyPad.end(), 0);
+    std::fill(display.begin(), display.end(), 0);
+    std::fill(pc.begin(), pc.end(), fresh.pc);
+    std::fill(blockPc.begin(), blockPc.end(), fresh.pc);
+    std::fill(blockConverged.begin(), blockConverged.end(), true);
+    for(std::size_t lane = 0; lane < stride; lane++) {
+        std::memcpy(&memory[lane * MEMORY_SIZE], fresh.memory.data(), MEMORY_SIZE);
+    }
+    std::fill(codeWriteBegin.begin(), codeWriteBegin.end(), 0xFFFF);
+    std::fill(codeWriteEnd.begin(), codeWriteEnd.end(), 0);
+
+    programSize = fresh.program_size;
+    cycleCount = 0;
+    return FailStates::SUCCESS;
+}
+
+void LockstepEngine::seedRandom(std::size_t lane, std::uint64_t seed) {
+    RandomEngine engine(seed);
+    randomState[lane] = engine.state;
+}
+
+void LockstepEngine::setKey(std::size_t lane, std::uint8_t key, bool pressed) {
+    keyPad[(key & 0xFu) * stride + lane] = pressed;
+}
+
+void LockstepEngine::run(std::uint64_t cycles) {
+    //block after block, a block's state stays in cache for the whole run
+    for(std::size_t block = 0; block < stride / BLOCK_SIZE; block++) {
+        for(std::uint64_t i = 0; i < cycles; i++) stepBlock(block);
+    }
+    cycleCount += cycles;
+}
+
+void LockstepEngine::tickTimers() {
+    for(std::size_t lane = 0; lane < stride; lane++) {
+        if(delayTimer[lane] > 0) --delayTimer[lane];
+        if(soundTimer[lane] > 0) --soundTimer[lane];
+    }
+}
+
+void LockstepEngine::diverge(std::size_t block, std::uint16_t address) {
+    std::fill(&pc[block * BLOCK_SIZE], &pc[block * BLOCK_SIZE] + BLOCK_SIZE, address);
+    blockConverged[block] = false;
+}
+
+void LockstepEngine::tryConverge(std::size_t block) {
+    std::size_t first = block * BLOCK_SIZE;
+    std::size_t last = std::min(first + BLOCK_SIZE, lanes);
+    for(std::size_t lane = first + 1; lane < last; lane++) {
+        if(pc[lane] != pc[first]) return;
+    }
+    blockPc[block] = pc[first];
+    blockConverged[block] = true;
+}
+
+void LockstepEngine::stepBlock(std::size_t block) {
+    std::size_t first = block * BLOCK_SIZE;
+    std::size_t last = std::min(first + BLOCK_SIZE, lanes);
+
+    std::uint16_t address = blockPc[block];
+    //a lane that rewrote the instruction may not execute what lane 0 has there
+    if(blockConverged[block] && address + 1 >= codeWriteBegin[block] && address < codeWriteEnd[block]) {
+        diverge(block, address);
+    }
+
+    if(!blockConverged[block]) {
+        ++stats.divergedSteps;
+        for(std::size_t lane = first; lane < last; lane++) stepLane(lane);
+        tryConverge(block);
+        return;
+    }
+    ++stats.convergedSteps;
+
+    const std::uint8_t* code = &memory[first * MEMORY_SIZE];
+    std::uint16_t opcode = fetch(code, address);
+    Chip8::Operands args = Chip8::splitOperands(opcode);
+    Op op = OP_TABLE[opTableIndex(opcode)];
+    std::uint16_t next = address + 2;
+
+    BlockRegisters registerBlock{&registers[first], stride};
+    std::uint32_t skips = 0;
+#ifdef CHIP8_LOCKSTEP_AVX2
+    bool vectorized = avx2 ? executeAvx2(op, args, registerBlock, skips) : executeGeneric(op, args, registerBlock, skips);
+#else
+    bool vectorized = executeGeneric(op, args, registerBlock, skips);
+#endif
+    if(vectorized) {
+        ++stats.vectorSteps;
+        skips &= activeLanes[block];
+        if(skips == 0) {
+            blockPc[block] = next;
+        }
+        else if(skips == activeLanes[block]) {
+            blockPc[block] = next + 2;
+        }
+        else {
+            //some lanes skip, from here on every lane has its own pc
+            diverge(block, next);
+            for(std::size_t i = 0; i < BLOCK_SIZE; i++) {
+                pc[first + i] += ((skips >> i) & 1u) * 2u;
+            }
+        }
+        return;
+    }
+
+    switch(op) {
+        case Op::OP_1NNN:
+            blockPc[block] = args.nnn;
+            return;
+        case Op::OP_00EE:
+        case Op::OP_BNNN:
+        case Op::OP_EX9E:
+        case Op::OP_EXA1:
+        case Op::OP_FX0A:
+            //the next pc depends on the lane's stack, registers or keys
+            diverge(block, next);
+            for(std::size_t lane = first; lane < last; lane++) executeLane(lane, op, args);
+            tryConverge(block);
+            return;
+        default:
+            //2NNN pushes each lane's own stack but all of them continue at NNN
+            for(std::size_t lane = first; lane < last; lane++) {
+                pc[lane] = next;
+                executeLane(lane, op, args);
+            }
+            blockPc[block] = pc[first];
+            return;
+    }
+}
+
+void LockstepEngine::stepLane(std::size_t lane) {
+    const std::uint8_t* code = &memory[lane * MEMORY_SIZE];
+    std::uint16_t address = pc[lane];
+    std::uint16_t opcode = fetch(code, address);
+    pc[lane] = address + 2;
+    executeLane(lane, OP_TABLE[opTableIndex(opcode)], Chip8::splitOperands(opcode));
+}
+
+void LockstepEngine::recordWrite(std::size_t lane, std::uint16_t address, std::uint16_t length) {
+    //the writes went to (I + i) & 0xFFF, a range past the end continues at 0 like Chip8::invalidateCode
+    address &= MEMORY_SIZE - 1;
+    if(address + length > MEMORY_SIZE) {
+        recordWrite(lane, 0, address + length - MEMORY_SIZE);
+        length = MEMORY_SIZE - address;
+    }
+    std::size_t block = lane / BLOCK_SIZE;
+    codeWriteBegin[block] = std::min(codeWriteBegin[block], address);
+    codeWriteEnd[block] = std::max<std::uint16_t>(codeWriteEnd[block], address + length);
+}
+
+void LockstepEngine::executeLane(std::size_t lane, Op op, const Chip8::Operands& args) {
+    //the Chip8 handlers with every field indexed by lane, pc already points past the instruction
+    auto reg = [&](std::uint8_t index) -> std::uint8_t& { return registers[index * stride + lane]; };
+    std::uint8_t* mem = &memory[lane * MEMORY_SIZE];
+    std::uint64_t* screen = &display[lane * FrameBuffer::LORES_HEIGHT];
+    std::uint16_t& counter = pc[lane];
+    std::uint16_t& index = vi[lane];
+
+    switch(op) {
+        case Op::OP_NULL:
+            break;
+        case Op::OP_00E0:
+            std::fill(screen, screen + FrameBuffer::LORES_HEIGHT, 0);
+            break;
+        case Op::OP_00EE:
+            --sp[lane];
+            counter = stack[(sp[lane] & 0xFu) * stride + lane];
+            break;
+        case Op::OP_1NNN:
+            counter = args.nnn;
+            break;
+        case Op::OP_2NNN:
+            stack[(sp[lane] & 0xFu) * stride + lane] = counter;
+            ++sp[lane];
+            counter = args.nnn;
+            break;
+        case Op::OP_3XNN:
+            if(reg(args.x) == args.nn) counter += 2;
+            break;
+        case Op::OP_4XNN:
+            if(reg(args.x) != args.nn) counter += 2;
+            break;
+        case Op::OP_5XY0:
+            if(reg(args.x) == reg(args.y)) counter += 2;
+            break;
+        case Op::OP_6XNN:
+            reg(args.x) = args.nn;
+            break;
+        case Op::OP_7XNN:
+            reg(args.x) += args.nn;
+            break;
+        case Op::OP_8XY0:
+            reg(args.x) = reg(args.y);
+            break;
+        case Op::OP_8XY1:
+            reg(args.x) |= reg(args.y);
+            break;
+        case Op::OP_8XY2:
+            reg(args.x) &= reg(args.y);
+            break;
+        case Op::OP_8XY3:
+            reg(args.x) ^= reg(args.y);
+            break;
+        case Op::OP_8XY4: {
+            std::uint16_t result = reg(args.x) + reg(args.y);
+            reg(0xF) = result > 0xFFu;
+            reg(args.x) = result & 0xFFu;
+            break;
+        }
+        case Op::OP_8XY5:
+            reg(0xF) = reg(args.x) > reg(args.y);
+            reg(args.x) -= reg(args.y);
+            break;
+        case Op::OP_8XY6:
+            reg(args.x) = reg(args.y) >> 1u;
+            reg(0xF) = reg(args.y) & 0x01u;
+            break;
+        case Op::OP_8XY7:
+            reg(0xF) = reg(args.y) > reg(args.x);
+            reg(args.x) = reg(args.y) - reg(args.x);
+            break;
+        case Op::OP_8XYE:
+            reg(args.x) = reg(args.y) << 1u;
+            reg(0xF) = (reg(args.y) & 0x80u) >> 7u;
+            break;
+        case Op::OP_9XY0:
+            if(reg(args.x) != reg(args.y)) counter += 2;
+            break;
+        case Op::OP_ANNN:
+            index = args.nnn;
+            break;
+        case Op::OP_BNNN:
+            counter = args.nnn + reg(0x0);
+            break;
+        case Op::OP_CXNN: {
+            RandomEngine engine;
+            engine.state = randomState[lane];
+            reg(args.x) = static_cast<std::uint8_t>(engine() >> 56u) & args.nn;
+            randomState[lane] = engine.state;
+            break;
+        }
+        case Op::OP_DXYN: {
+            std::uint8_t xPos = reg(args.x) & (FrameBuffer::LORES_WIDTH - 1);
+            std::uint8_t yPos = reg(args.y) & (FrameBuffer::LORES_HEIGHT - 1);
+            std::uint8_t rows = std::min<std::uint8_t>(args.n, FrameBuffer::LORES_HEIGHT - yPos);
+            std::uint64_t collision = 0;
+            for(std::uint8_t row = 0; row < rows; row++) {
+                std::uint64_t spriteRow = (std::uint64_t(mem[(index + row) & 0xFFFu]) << (FrameBuffer::LORES_WIDTH - 8)) >> xPos;
+                collision |= screen[yPos + row] & spriteRow;
+                screen[yPos + row] ^= spriteRow;
+            }
+            reg(0xF) = collision != 0;
+            break;
+        }
+        case Op::OP_EX9E:
+            if(keyPad[(reg(args.x) & 0xFu) * stride + lane]) counter += 2;
+            break;
+        case Op::OP_EXA1:
+            if(!keyPad[(reg(args.x) & 0xFu) * stride + lane]) counter += 2;
+            break;
+        case Op::OP_FX07:
+            reg(args.x) = delayTimer[lane];
+            break;
+        case Op::OP_FX0A: {
+            bool pressed = false;
+            for(std::uint8_t key = 0; key < 16; key++) {
+                if(keyPad[key * stride + lane]) {
+                    pressed = true;
+                    reg(args.x) = key;
+                    break;
+                }
+            }
+            if(!pressed) counter -= 2;
+            break;
+        }
+        case Op::OP_FX15:
+            delayTimer[lane] = reg(args.x);
+            break;
+        case Op::OP_FX18:
+            soundTimer[lane] = reg(args.x);
+            break;
+        case Op::OP_FX1E:
+            index += reg(args.x);
+            break;
+        case Op::OP_FX29:
+            index = Chip8::fontset_start_address + 5 * reg(args.x);
+            break;
+        case Op::OP_FX33: {
+            std::uint8_t value = reg(args.x);
+            for(int i = 2; i >= 0; i--) {
+                mem[(index + i) & 0xFFFu] = value % 10;
+                value /= 10;
+            }
+            recordWrite(lane, index, 3);
+            break;
+        }
+        case Op::OP_FX55:
+            for(std::uint8_t i = 0; i <= args.x; i++) {
+                mem[(index + i) & 0xFFFu] = reg(i);
+            }
+            recordWrite(lane, index, args.x + 1);
+            break;
+        case Op::OP_FX65:
+            for(std::uint8_t i = 0; i <= args.x; i++) {
+                reg(i) = mem[(index + i) & 0xFFFu];
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void LockstepEngine::exportLane(std::size_t lane, Chip8& chip8) const {
+    for(std::uint8_t i = 0; i < 16; i++) {
+        chip8.registers[i] = registers[i * stride + lane];
+        chip8.stack[i] = stack[i * stride + lane];
+        chip8.keyPad[i] = keyPad[i * stride + lane] != 0;
+    }
+    chip8.vi = vi[lane];
+    std::size_t block = lane / BLOCK_SIZE;
+    chip8.pc = blockConverged[block] ? blockPc[block] : pc[lane];
+    chip8.sp = sp[lane];
+    chip8.delay_timer = delayTimer[lane];
+    chip8.sound_timer = soundTimer[lane];
+    chip8.randomEngine.state = randomState[lane];
+    chip8.cycleCount = cycleCount;
+    chip8.program_size = programSize;
+    chip8.romLoaded = programSize > 0;
+    std::memcpy(chip8.memory.data(), &memory[lane * MEMORY_SIZE], MEMORY_SIZE);
+    std::fill(chip8.memory.begin() + MEMORY_SIZE, chip8.memory.end(), 0);
+    chip8.display = FrameBuffer{};
+    std::copy_n(&display[lane * FrameBuffer::LORES_HEIGHT], FrameBuffer::LORES_HEIGHT, chip8.display.planes[0].left.begin());
+
+    chip8.invalidateCode(0, MEMORY_SIZE);
+    ++chip8.displayGeneration;
+}
+
+const LockstepStats& LockstepEngine::getStats() const {
+    return stats;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "Chip8.h"
+
+struct LockstepStats {
+    //block steps where all lanes were at the same address and shared the instruction
+    std::uint64_t convergedSteps{};
+    //of those, steps executed with vector instructions
+    std::uint64_t vectorSteps{};
+    //block steps that fell back to one lane at a time
+    std::uint64_t divergedSteps{};
+};
+
+/**
+ * Many instances of the same ROM in structure-of-arrays form, e.g. registers[16][lanes].
+ *
+ * Lanes are grouped in blocks of 32, one AVX2 register of 8-bit values per Chip8 register.
+ * While every lane of a block is at the same address, the instruction is fetched and decoded once,
+ * ALU instructions and skips run on all 32 lanes with vector instructions, and everything
+ * else loops over the lanes with the decoded operands. Once lanes diverge (skips,
+ * computed jumps, their own rewritten code) the block steps one lane at a time until they meet again.
+ *
+ * Every lane behaves exactly like a Chip8 on the Interpreter engine, exportLane() copies one out.
+ * AVX2 is used when the host supports it, other hosts run the same blocks with plain loops.
+ * Idle loops are not fast-forwarded and lanes always have the default quirk profile,
+ * so ROMs are limited to 4 KB of memory and the 64x32 display. Instructions are still fetched from
+ * the whole 64 KB like on a Chip8, past the 4 KB a lane holds they read as zero.
+ */
+class LockstepEngine {
+    public:
+        const static std::size_t BLOCK_SIZE = 32;
+        const static std::size_t MEMORY_SIZE = 4096;
+
+    private:
+        std::size_t lanes;
+        //lanes rounded up to whole blocks, the row length of every [n][stride] array
+        std::size_t stride;
+
+        std::vector<std::uint8_t> registers;    //[16][stride]
+        std::vector<std::uint16_t> vi;          //[stride]
+        std::vector<std::uint16_t> pc;          //[stride]
+        std::vector<std::uint16_t> stack;       //[16][stride]
+        std::vector<std::uint8_t> sp;           //[stride]
+        std::vector<std::uint8_t> delayTimer;   //[stride]
+        std::vector<std::uint8_t> soundTimer;   //[stride]
+        std::vector<std::uint8_t> keyPad;       //[16][stride]
+        std::vector<std::uint64_t> randomState; //[stride]
+        std::vector<std::uint8_t> memory;       //[stride][MEMORY_SIZE]
+        std::vector<std::uint64_t> display;     //[stride][LORES_HEIGHT]
+
+        //per block: while converged, the one pc of all its lanes lives in blockPc and pc[] is stale
+        std::vector<std::uint16_t> blockPc;
+        std::vector<std::uint8_t> blockConverged;
+        //bit per lane of the block that is not padding
+        std::vector<std::uint32_t> activeLanes;
+
+        //union of the addresses each block's lanes wrote, instructions in it are fetched per lane
+        std::vector<std::uint16_t> codeWriteBegin;
+        std::vector<std::uint16_t> codeWriteEnd;
+
+        std::uint16_t programSize{};
+        std::uint64_t cycleCount{};
+        bool avx2{false};
+        LockstepStats stats;
+
+        void stepBlock(std::size_t block);
+        void stepLane(std::size_t lane);
+        void diverge(std::size_t block, std::uint16_t address);
+        void tryConverge(std::size_t block);
+        void executeLane(std::size_t lane, Op op, const Chip8::Operands& args);
+        void recordWrite(std::size_t lane, std::uint16_t address, std::uint16_t length);
+
+    public:
+        /**
+         * @param lanes: Number of instances, all start as a fresh Chip8
+         */
+        explicit LockstepEngine(std::size_t lanes);
+
+        std::size_t size() const;
+
+        static bool avx2Supported();
+
+        /**
+         * Use AVX2 for converged blocks, ignored if the host does not support it
+         */
+        void setAvx2(bool enabled);
+        bool usingAvx2() const;
+
+        /**
+         * Load the same ROM into every lane and reset them
+         * @return: FailStates::SUCCESS, ROM_EMPTY or ROM_TOO_LARGE
+         */
+        std::uint8_t loadRom(const std::uint8_t* data, std::size_t size);
+
+        void seedRandom(std::size_t lane, std::uint64_t seed);
+        void setKey(std::size_t lane, std::uint8_t key, bool pressed);
+
+        /**
+         * Execute exactly the given number of instructions on every lane
+         */
+        void run(std::uint64_t cycles);
+
+        /**
+         * Decrement the timers of every lane, once per 60 Hz frame
+         */
+        void tickTimers();
+
+        /**
+         * Copy the state of one lane into a Chip8, e.g. to hash, draw or save it.
+         * The last opcode is not tracked per lane and is left as it was
+         */
+        void exportLane(std::size_t lane, Chip8& chip8) const;
+
+        const LockstepStats& getStats() const;
+};
@@ -1,39 +1,105 @@
 #include "Machine.h"
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+//the COSMAC VIP keypad on the left of a QWERTY keyboard:
+//1 2 3 C    1 2 3 4
+//4 5 6 D    q w e r
+//7 8 9 E    a s d f
+//A 0 B F    z x c v
+static const char* DEFAULT_KEYMAP = "x123qweasdzc4rfv";
+
 Machine::Machine(
         const std::string &title, int scale, float frequency = 60
 ) : window{
     sf::RenderWindow(
     sf::VideoMode(
-            chip8.DISPLAY_WIDTH * scale,
-            chip8.DISPLAY_HEIGHT * scale),title,
+            FrameBuffer::LORES_WIDTH * scale,
+            FrameBuffer::LORES_HEIGHT * scale),title,
             sf::Style::Close
     )
-}, chip8{} {
+}, chip8{}, audio(audioSink, frequency) {
     this->frequency = frequency;
     this->scale = scale;
+    this->title = title;
+
+    //the fastest portable engine, the scheduler runs whole frames at once
+    chip8.setEngine(Chip8::Engine::Threaded);
 
-    pixel = sf::RectangleShape(sf::Vector2f(scale, scale));
-    pixel.setFillColor(foregroundColor);
+    framePixels.resize(FrameBuffer::WIDTH * FrameBuffer::HEIGHT * 4);
+    texture.create(FrameBuffer::WIDTH, FrameBuffer::HEIGHT);
+    sprite.setTexture(texture);
+
+    setKeymap(DEFAULT_KEYMAP);
 }
 
 void Machine::draw() {
+    //take the newest frame, or present the previous one again
+    bool fresh = frames.update();
+    if(fresh) {
+        const VideoFrame& frame = frames.readSlot();
+        if(shownFrame > 0 && frame.number > shownFrame + 1) {
+            frameStats.droppedFrames += frame.number - shownFrame - 1;
+        }
+        shownFrame = frame.number;
+    }
+    else {
+        ++frameStats.duplicatedFrames;
+    }
+    const VideoFrame& frame = frames.readSlot();
 
-    //the default clear color is black
-    window.clear(backgroundColor);
-
-    for(std::size_t i = 0; i < chip8.DISPLAY_HEIGHT; i++) {
-        for(std::size_t j = 0; j < chip8.DISPLAY_WIDTH; j++) {
-            //if the pixel at this position is set
-            if(chip8.display[i * chip8.DISPLAY_WIDTH + j]) {
-                pixel.setPosition(j * scale, i * scale);
-                window.draw(pixel);
+    //expand the planes into RGBA texels only when they changed, the window keeps its size in both resolutions
+    if(redraw || frame.generation != drawnGeneration) {
+        std::size_t width = frame.display.width();
+        std::size_t height = frame.display.height();
+        for(std::size_t i = 0; i < height; i++) {
+            for(std::size_t j = 0; j < width; j++) {
+                const sf::Color& color = palette[frame.display.pixel(j, i)];
+                sf::Uint8* texel = &framePixels[(i * width + j) * 4];
+                texel[0] = color.r;
+                texel[1] = color.g;
+                texel[2] = color.b;
+                texel[3] = color.a;
             }
         }
+        texture.update(framePixels.data(), width, height, 0, 0);
+        sprite.setTextureRect(sf::IntRect(0, 0, width, height));
+        float pixelScale = float(scale) * FrameBuffer::LORES_WIDTH / width;
+        sprite.setScale(pixelScale, pixelScale);
+        drawnGeneration = frame.generation;
+        redraw = false;
     }
 
+    window.clear(palette[0]);
+    window.draw(sprite);
     window.display();
 
+    auto presented = std::chrono::steady_clock::now();
+    if(shownFrame > 0) {
+        double latencyUs = std::chrono::duration<double, std::micro>(presented - frame.published).count();
+        windowLatencyUs += latencyUs;
+        windowMaxLatencyUs = std::max(windowMaxLatencyUs, latencyUs);
+        ++windowPresents;
+    }
+    //a press that landed in a dropped frame is not measured
+    if(fresh && frame.hasInput) {
+        double latencyUs = std::chrono::duration<double, std::micro>(presented - frame.inputTime).count();
+        windowInputLatencyUs += latencyUs;
+        windowMaxInputLatencyUs = std::max(windowMaxInputLatencyUs, latencyUs);
+        ++windowInputs;
+    }
+}
+
+void Machine::sendKey(std::uint8_t key, bool pressed) {
+    if(heldKeys[key] == pressed) return;
+    heldKeys[key] = pressed;
+    if(!keyEvents.push({key, pressed, std::chrono::steady_clock::now()})) {
+        ++frameStats.droppedKeyEvents;
+    }
 }
 
 void Machine::processInput() {
@@ -45,54 +111,205 @@ void Machine::processInput() {
             break;
         }
 
+        if(event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus) {
+            redraw = true;
+        }
+
         if(event.type == sf::Event::KeyPressed) {
             //TODO: add dynamic ROM loading
             if(event.key.code == sf::Keyboard::Escape) {
                 window.close();
                 break;
             }
+            if(event.key.code == sf::Keyboard::Backspace) {
+                //a rewind can not be described by the input log
+                rewinding = recordPath.empty();
+                continue;
+            }
+            if(event.key.code == sf::Keyboard::Tab) {
+                turbo = !turbo;
+                continue;
+            }
 
-            chip8.keyPad[0x0] = event.key.code == sf::Keyboard::X;
-            chip8.keyPad[0x1] = event.key.code == sf::Keyboard::Num1;
-            chip8.keyPad[0x2] = event.key.code == sf::Keyboard::Num2;
-            chip8.keyPad[0x3] = event.key.code == sf::Keyboard::Num3;
-            chip8.keyPad[0x4] = event.key.code == sf::Keyboard::Q;
-            chip8.keyPad[0x5] = event.key.code == sf::Keyboard::W;
-            chip8.keyPad[0x6] = event.key.code == sf::Keyboard::E;
-            chip8.keyPad[0x7] = event.key.code == sf::Keyboard::A;
-            chip8.keyPad[0x8] = event.key.code == sf::Keyboard::S;
-            chip8.keyPad[0x9] = event.key.code == sf::Keyboard::D;
-            chip8.keyPad[0xA] = event.key.code == sf::Keyboard::Z;
-            chip8.keyPad[0xB] = event.key.code == sf::Keyboard::C;
-            chip8.keyPad[0xC] = event.key.code == sf::Keyboard::Num4;
-            chip8.keyPad[0xD] = event.key.code == sf::Keyboard::R;
-            chip8.keyPad[0xE] = event.key.code == sf::Keyboard::F;
-            chip8.keyPad[0xF] = event.key.code == sf::Keyboard::V;
+            if(event.key.code >= 0 && event.key.code < sf::Keyboard::KeyCount && keymap[event.key.code] >= 0) {
+                sendKey(keymap[event.key.code], true);
+            }
         }
         if(event.type == sf::Event::KeyReleased) {
-            chip8.keyPad[0x1] = chip8.keyPad[0x1] && !(event.key.code == sf::Keyboard::Num1);
-            chip8.keyPad[0x2] = chip8.keyPad[0x2] && !(event.key.code == sf::Keyboard::Num2);
-            chip8.keyPad[0x3] = chip8.keyPad[0x3] && !(event.key.code == sf::Keyboard::Num3);
-            chip8.keyPad[0xc] = chip8.keyPad[0xc] && !(event.key.code == sf::Keyboard::Num4);
-            chip8.keyPad[0x4] = chip8.keyPad[0x4] && !(event.key.code == sf::Keyboard::Q);
-            chip8.keyPad[0x5] = chip8.keyPad[0x5] && !(event.key.code == sf::Keyboard::W);
-            chip8.keyPad[0x6] = chip8.keyPad[0x6] && !(event.key.code == sf::Keyboard::E);
-            chip8.keyPad[0x7] = chip8.keyPad[0x7] && !(event.key.code == sf::Keyboard::A);
-            chip8.keyPad[0x8] = chip8.keyPad[0x8] && !(event.key.code == sf::Keyboard::S);
-            chip8.keyPad[0x9] = chip8.keyPad[0x9] && !(event.key.code == sf::Keyboard::D);
-            chip8.keyPad[0xe] = chip8.keyPad[0xe] && !(event.key.code == sf::Keyboard::F);
-            chip8.keyPad[0xd] = chip8.keyPad[0xd] && !(event.key.code == sf::Keyboard::R);
-            chip8.keyPad[0xa] = chip8.keyPad[0xa] && !(event.key.code == sf::Keyboard::Z);
-            chip8.keyPad[0x0] = chip8.keyPad[0x0] && !(event.key.code == sf::Keyboard::X);
-            chip8.keyPad[0xb] = chip8.keyPad[0xb] && !(event.key.code == sf::Keyboard::C);
-            chip8.keyPad[0xf] = chip8.keyPad[0xf] && !(event.key.code == sf::Keyboard::V);
+            if(event.key.code == sf::Keyboard::Backspace) {
+                rewinding = false;
+                continue;
+            }
+            if(event.key.code >= 0 && event.key.code < sf::Keyboard::KeyCount && keymap[event.key.code] >= 0) {
+                sendKey(keymap[event.key.code], false);
+            }
+        }
+        //the releases would go to another window
+        if(event.type == sf::Event::LostFocus) {
+            for(std::uint8_t key = 0; key < heldKeys.size(); key++) {
+                sendKey(key, false);
+            }
+        }
+    }
+}
+
+void Machine::processSound(std::uint64_t instructions) {
+    audio.frame(chip8, instructions, !rewinding && !turbo);
+}
+
+void Machine::emulateFrame(Scheduler& scheduler, bool capture) {
+    //the frame's instructions are always taken so the schedule does not catch up after a rewind
+    std::uint64_t instructions = scheduler.instructionsForFrame();
+    pollKeys(instructions);
+    if(rewinding) {
+        //stays on the oldest frame once the history runs out, with the keys the player holds now
+        input.clear();
+        rewind.stepBack(chip8);
+        for(std::uint8_t key = 0; key < hostKeys.size(); key++) {
+            chip8.keyPad[key] = hostKeys[key];
+        }
+        processSound(instructions);
+        return;
+    }
+
+    std::uint64_t idleBefore = chip8.idleCycles;
+    input.run(chip8, instructions, [this](std::uint64_t n) { chip8.run(n); });
+    scheduler.reportIdle(chip8.idleCycles - idleBefore);
+
+    //the timers run at 60 Hz of emulated time, in turbo mode too
+    chip8.tickTimers();
+    if(capture) rewind.capture(chip8);
+    processSound(instructions);
+}
+
+void Machine::pollKeys(std::uint64_t instructions) {
+    //the events arrived while the previous frame ran and slept. Each one is placed at the same
+    //fraction of the coming frame as it had of that wall clock interval, so presses keep their
+    //order and spacing in emulated time instead of all landing on the frame boundary
+    auto now = std::chrono::steady_clock::now();
+    double interval = std::chrono::duration<double>(now - lastKeyPoll).count();
+    std::uint64_t frameStart = chip8.cycleCount;
+    std::uint64_t last = instructions > 0 ? instructions - 1 : 0;
+
+    KeyEvent event;
+    while(keyEvents.pop(event)) {
+        hostKeys[event.key] = event.pressed;
+        if(rewinding) continue;
+
+        double fraction = interval > 0 ? std::chrono::duration<double>(event.time - lastKeyPoll).count() / interval : 0;
+        fraction = std::clamp(fraction, 0.0, 1.0);
+        std::uint64_t offset = std::min<std::uint64_t>(static_cast<std::uint64_t>(fraction * instructions), last);
+        InputEvent scheduled{frameStart + offset, event.key, event.pressed};
+        input.push(scheduled);
+        if(!recordPath.empty()) record.events.push_back(scheduled);
+
+        if(event.pressed && !hasInput) {
+            hasInput = true;
+            inputTime = event.time;
+        }
+    }
+    lastKeyPoll = now;
+}
+
+void Machine::publishFrame(const SchedulerStats& stats, std::uint64_t statsSerial) {
+    VideoFrame& frame = frames.writeSlot();
+    //the slot holds the frame of two publishes ago, its display is often still current
+    if(frame.generation != chip8.displayGeneration) {
+        frame.display = chip8.display;
+        frame.generation = chip8.displayGeneration;
+    }
+    frame.number = ++publishedFrames;
+    frame.stats = stats;
+    frame.statsSerial = statsSerial;
+    frame.turbo = turbo.load(std::memory_order_relaxed);
+    frame.hasInput = hasInput;
+    frame.inputTime = inputTime;
+    hasInput = false;
+    frame.published = std::chrono::steady_clock::now();
+    frames.publish();
+}
 
+void Machine::emulationLoop() {
+    //one 60 Hz frame per iteration: a batch of instructions, one timer tick,
+    //one published frame, then sleep until the next frame is due.
+    //In turbo mode an iteration runs as many frames as fit into one host frame instead
+    Scheduler scheduler(frequency);
+    bool wasTurbo = turbo;
+    SchedulerStats stats;
+    std::uint64_t statsSerial = 0;
+    lastKeyPoll = std::chrono::steady_clock::now();
+
+    while(running.load(std::memory_order_acquire)) {
+        bool turboNow = turbo.load(std::memory_order_relaxed);
+        if(wasTurbo && !turboNow) {
+            //back to real time from now, not from when turbo started
+            scheduler.reset();
+        }
+        wasTurbo = turboNow;
+
+        if(turboNow) {
+            //publish after every frameSkip-th frame, or after one host frame at the latest
+            auto sliceEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(1000000 / Scheduler::FRAME_RATE);
+            unsigned frameCount = 0;
+            do {
+                emulateFrame(scheduler, false);
+                ++frameCount;
+            } while((frameSkip == 0 || frameCount < frameSkip) && std::chrono::steady_clock::now() < sliceEnd);
+            //one rewind step per published frame, capturing every emulated frame would cost more than running it
+            if(!rewinding) rewind.capture(chip8);
         }
+        else {
+            emulateFrame(scheduler, true);
+        }
+
+        if(scheduler.statsReady()) {
+            stats = scheduler.getStats();
+            ++statsSerial;
+        }
+        publishFrame(stats, statsSerial);
+
+        if(!turboNow) scheduler.waitForNextFrame();
     }
 }
 
-void Machine::processSound() {
-    //TODO: add sound
+void Machine::updateTitle(const VideoFrame& frame) {
+    frameStats.meanLatencyUs = windowPresents > 0 ? windowLatencyUs / windowPresents : 0;
+    frameStats.maxLatencyUs = windowMaxLatencyUs;
+    windowLatencyUs = 0;
+    windowMaxLatencyUs = 0;
+    windowPresents = 0;
+    frameStats.meanInputLatencyUs = windowInputs > 0 ? windowInputLatencyUs / windowInputs : 0;
+    frameStats.maxInputLatencyUs = windowMaxInputLatencyUs;
+    windowInputLatencyUs = 0;
+    windowMaxInputLatencyUs = 0;
+    windowInputs = 0;
+
+    const SchedulerStats& stats = frame.stats;
+    std::string status = title + " - " + std::to_string(static_cast<int>(stats.instructionsPerSecond + 0.5)) + " IPS";
+    if(frame.turbo) {
+        char speed[32];
+        std::snprintf(speed, sizeof(speed), ", turbo x%.1f", stats.speedMultiplier);
+        status += speed;
+    }
+    else {
+        status += ", jitter " + std::to_string(static_cast<int>(stats.meanJitterUs)) +
+                  " us (max " + std::to_string(static_cast<int>(stats.maxJitterUs)) + " us)";
+    }
+    status += ", idle " + std::to_string(static_cast<int>(stats.idleFraction * 100 + 0.5)) + "%";
+    status += ", latency " + std::to_string(static_cast<int>(frameStats.meanLatencyUs / 1000 + 0.5)) + " ms";
+    if(frameStats.maxInputLatencyUs > 0) {
+        status += ", input " + std::to_string(static_cast<int>(frameStats.meanInputLatencyUs / 1000 + 0.5)) +
+                  " ms (max " + std::to_string(static_cast<int>(frameStats.maxInputLatencyUs / 1000 + 0.5)) + " ms)";
+    }
+    if(frameStats.droppedKeyEvents > 0) status += ", keys dropped " + std::to_string(frameStats.droppedKeyEvents);
+    if(frameStats.droppedFrames > 0 || frameStats.duplicatedFrames > 0) {
+        status += ", frames dropped " + std::to_string(frameStats.droppedFrames) +
+                  " duplicated " + std::to_string(frameStats.duplicatedFrames);
+    }
+    //glitches the player could hear
+    AudioStats audioStats = audio.getStats();
+    if(audioStats.underruns > 0) status += ", audio underruns " + std::to_string(audioStats.underruns);
+    window.setTitle(status);
 }
 
 void Machine::runLoop() {
@@ -101,50 +318,99 @@ void Machine::runLoop() {
         exit(FailStates::ROM_NOT_LOADED);
     }
 
-    //the main clock
-    sf::Clock clock;
-
-    //CPU frequency
-    sf::Time cpuClockSpeed = sf::seconds(1.f / frequency);
-    sf::Time cpuClockAccumulator = sf::Time::Zero;
-
-    //timer frequency
-    sf::Time timerClockSpeed = sf::seconds(1.f / 60.f);
-    sf::Time timerClockAccumulator = sf::Time::Zero;
+    //the UI presents at the host frame rate, whatever the emulation thread is doing
+    window.setFramerateLimit(Scheduler::FRAME_RATE);
+    //a held key is one press, not a stream of them
+    window.setKeyRepeatEnabled(false);
+    for(std::uint8_t key = 0; key < heldKeys.size(); key++) {
+        heldKeys[key] = chip8.keyPad[key];
+        hostKeys[key] = chip8.keyPad[key];
+    }
 
+    running = true;
+    audio.start();
+    emulation = std::thread(&Machine::emulationLoop, this);
 
     while(window.isOpen()) {
-        //managing the inputs
         processInput();
+        draw();
 
-        //managing the timers
-        if(cpuClockAccumulator >= cpuClockSpeed) {
-            chip8.cycle();
-            cpuClockAccumulator = sf::Time::Zero;
+        const VideoFrame& frame = frames.readSlot();
+        if(frame.statsSerial != shownStatsSerial) {
+            shownStatsSerial = frame.statsSerial;
+            updateTitle(frame);
         }
+    }
 
-        if(timerClockAccumulator >= timerClockSpeed) {
-            if(chip8.delay_timer > 0) {
-                chip8.delay_timer--;
-            }
-
-            if(chip8.sound_timer > 0) {
-                //TODO: process the sound
-                chip8.sound_timer--;
-            }
+    running = false;
+    emulation.join();
+    audio.stop();
 
-            timerClockAccumulator = sf::Time::Zero;
+    if(!recordPath.empty()) {
+        record.hasQuirks = true;
+        record.quirks = chip8.quirks;
+        record.hasEnd = true;
+        record.endCycle = chip8.cycleCount;
+        record.hasExpected = true;
+        record.registersHash = chip8.registersHash();
+        record.memoryHash = chip8.memoryHash();
+        record.displayHash = chip8.displayHash();
+        if(!record.save(recordPath)) {
+            std::cout << "ERROR: could not write the input log" << std::endl;
         }
+    }
+}
 
-        //drawing to the screen
-        draw();
+void Machine::setTurbo(bool enabled, unsigned skip) {
+    turbo = enabled;
+    frameSkip = skip;
+}
+
+void Machine::recordInput(const std::string& filePath) {
+    recordPath = filePath;
+
+    record = InputLog{};
+    record.hasSeed = true;
+    record.seed = std::random_device{}();
+    record.frequency = frequency;
+    chip8.seedRandom(record.seed);
+}
+
+bool Machine::setKeymap(const std::string& layout) {
+    if(layout.size() != 16) return false;
+
+    std::array<std::int8_t, sf::Keyboard::KeyCount> map;
+    map.fill(-1);
+    for(std::size_t key = 0; key < layout.size(); key++) {
+        char c = static_cast<char>(std::tolower(static_cast<unsigned char>(layout[key])));
+        int code;
+        if(c >= 'a' && c <= 'z') code = sf::Keyboard::A + (c - 'a');
+        else if(c >= '0' && c <= '9') code = sf::Keyboard::Num0 + (c - '0');
+        else return false;
+        //one host key can not stand for two chip8 keys
+        if(map[code] >= 0) return false;
+        map[code] = static_cast<std::int8_t>(key);
+    }
+    keymap = map;
+    return true;
+}
+
+void Machine::setQuirks(QuirkProfile profile) {
+    chip8.setQuirks(profile);
+}
 
-        //advancing the clock
-        cpuClockAccumulator += clock.getElapsedTime();
-        timerClockAccumulator += clock.restart();
+std::uint8_t Machine::loadRom(const std::string& filePath) {
+    std::uint8_t status = chip8.loadRom(filePath);
+    switch(status) {
+        case FailStates::SUCCESS: break;
+        case FailStates::FILE_NOT_FOUND: std::cout << "ERROR: ROM file not found" << std::endl; break;
+        case FailStates::ROM_EMPTY: std::cout << "ERROR: ROM file is empty" << std::endl; break;
+        case FailStates::ROM_TOO_LARGE: std::cout << "ERROR: ROM does not fit in memory" << std::endl; break;
     }
+    rewind.clear();
+    return status;
 }
 
-void Machine::loadRom(const std::string& filePath) {
-    chip8.loadRom(filePath);
+const FrameStats& Machine::getFrameStats() const {
+    return frameStats;
 }
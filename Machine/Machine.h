@@ -1,31 +1,227 @@
 #pragma once
 
 #include "Chip8.h"
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <thread>
+#include <vector>
 #include <iostream>
 #include "FailStates.h"
+#include "Scheduler.h"
+#include "RewindBuffer.h"
+#include "InputLog.h"
+#include "InputQueue.h"
+#include "AudioThread.h"
+#include "SfmlAudioSink.h"
+#include "SpscRing.h"
+#include "TripleBuffer.h"
 #include <SFML/Graphics.hpp>
 
+/**
+ * A finished emulated frame, handed from the emulation thread to the UI thread
+ */
+struct VideoFrame {
+    FrameBuffer display;
+    //chip8.displayGeneration of display, the UI only uploads a texture when it changed
+    std::uint32_t generation{};
+    //frames published so far, gaps are frames the UI never saw
+    std::uint64_t number{};
+    std::chrono::steady_clock::time_point published;
+
+    //the scheduler's latest statistics and how often they were renewed
+    SchedulerStats stats;
+    std::uint64_t statsSerial{};
+    bool turbo{false};
+
+    //host time of the oldest key press that first takes effect in this frame
+    bool hasInput{false};
+    std::chrono::steady_clock::time_point inputTime;
+};
+
+/**
+ * A keypad change as the UI thread saw it, on its way to the emulation thread
+ */
+struct KeyEvent {
+    std::uint8_t key;
+    bool pressed;
+    std::chrono::steady_clock::time_point time;
+};
+
+struct FrameStats {
+    //from publishing a frame to presenting it, over the last reporting window
+    double meanLatencyUs{};
+    double maxLatencyUs{};
+    //published frames that were overwritten before the UI took them
+    std::uint64_t droppedFrames{};
+    //presents without a new frame, the previous one was shown again
+    std::uint64_t duplicatedFrames{};
+
+    //from a key press to presenting the first frame it had an effect on, over the last reporting window
+    double meanInputLatencyUs{};
+    double maxInputLatencyUs{};
+    //key changes lost because the emulation thread fell behind
+    std::uint64_t droppedKeyEvents{};
+};
+
+/**
+ * The SFML frontend. Emulation runs on its own thread, paced by the Scheduler,
+ * and publishes every frame through a triple buffer. The UI thread polls input,
+ * translates it through the keymap into keypad events for the emulation thread
+ * and presents the newest frame at the host's frame rate, so neither thread ever waits for the other.
+ */
 class Machine {
     private:
         //the standard chip8 clock frequency is about 500 hz
         float frequency;
         int scale;
+        std::string title;
+        //owned by the emulation thread while runLoop runs
         Chip8 chip8;
         sf::RenderWindow window;
-        sf::RectangleShape pixel;
-        sf::Color backgroundColor = {255, 231, 122};
-        sf::Color foregroundColor = {44, 95, 45};
+        //indexed by the pixel colour: off, plane 0, plane 1, both planes
+        std::array<sf::Color, 4> palette = {
+            sf::Color(255, 231, 122),
+            sf::Color(44, 95, 45),
+            sf::Color(151, 188, 98),
+            sf::Color(0, 37, 51)
+        };
+
+        //the whole display is uploaded as one texture and drawn as one scaled sprite
+        sf::Texture texture;
+        sf::Sprite sprite;
+        std::vector<sf::Uint8> framePixels;
+
+        //VideoFrame::generation of the texture
+        std::uint32_t drawnGeneration{};
+        //set when the texture has to be uploaded even without a new generation
+        bool redraw{true};
+
+        TripleBuffer<VideoFrame> frames;
+        std::thread emulation;
+        std::atomic<bool> running{false};
+        //emulation thread: VideoFrame::number of the last published frame
+        std::uint64_t publishedFrames{};
+
+        //chip8 key of every host key, -1 if it is not mapped
+        std::array<std::int8_t, sf::Keyboard::KeyCount> keymap{};
+
+        //UI thread: the keypad as the host keyboard holds it, only changes become events
+        std::array<bool, 16> heldKeys{};
+        SpscRing<KeyEvent, 256> keyEvents;
+
+        //emulation thread: events spread over the frame they were collected in, see emulateFrame
+        InputQueue input;
+        std::array<bool, 16> hostKeys{};
+        std::chrono::steady_clock::time_point lastKeyPoll;
+        bool hasInput{false};
+        std::chrono::steady_clock::time_point inputTime;
+
+        //UI thread: the frame on screen and the statistics of the current window
+        std::uint64_t shownFrame{};
+        std::uint64_t shownStatsSerial{};
+        double windowLatencyUs{};
+        double windowMaxLatencyUs{};
+        std::uint64_t windowPresents{};
+        double windowInputLatencyUs{};
+        double windowMaxInputLatencyUs{};
+        std::uint64_t windowInputs{};
+        FrameStats frameStats;
+
+        //one state per frame, played backwards while Backspace is held
+        RewindBuffer rewind;
+        std::atomic<bool> rewinding{false};
+
+        //unthrottled, toggled with Tab
+        std::atomic<bool> turbo{false};
+        //in turbo mode, present after this many emulated frames, 0 presents once per host frame
+        unsigned frameSkip{};
+
+        //keypad changes of this session, written to recordPath when the window closes
+        std::string recordPath;
+        InputLog record;
+
+        //the beeper and XO-CHIP sound, synthesized on the audio thread from the state after every frame
+        SfmlAudioSink audioSink;
+        AudioThread audio;
+
+        /**
+         * Emulation thread: frames on the schedule until running is cleared
+         */
+        void emulationLoop();
+
+        /**
+         * UI thread: hand a keypad change to the emulation thread
+         */
+        void sendKey(std::uint8_t key, bool pressed);
+
+        /**
+         * Emulation thread: schedule the key events of the UI thread over the coming frame, recording them
+         * @param instructions: Instructions of the coming frame
+         */
+        void pollKeys(std::uint64_t instructions);
+
+        /**
+         * Emulation thread: hand the current display to the UI thread
+         */
+        void publishFrame(const SchedulerStats& stats, std::uint64_t statsSerial);
+
+        void updateTitle(const VideoFrame& frame);
     public:
         Machine(
                 const std::string& title,
                 int scale, float frequency
         );
 
+        /**
+         * UI thread: present the newest published frame
+         */
         void draw();
+        /**
+         * One 60 Hz frame of emulated time: the scheduled instructions and one timer tick
+         * @param capture: Store the frame in the rewind buffer
+         */
+        void emulateFrame(Scheduler& scheduler, bool capture);
         void processInput();
-        void processSound();
+        /**
+         * Hand the sound state at the end of a frame to the audio thread, muted while rewinding and in turbo mode
+         */
+        void processSound(std::uint64_t instructions);
         void runLoop();
-        void loadRom(const std::string& filePath);
+        /**
+         * @return: FailStates::SUCCESS, or why the ROM was not loaded
+         */
+        std::uint8_t loadRom(const std::string& filePath);
+
+        /**
+         * Run as fast as the host allows, the timers still tick once per frequency / 60 instructions
+         * @param frameSkip: Present after every frameSkip-th emulated frame, 0 to present once per host frame
+         */
+        void setTurbo(bool enabled, unsigned frameSkip = 0);
+
+        /**
+         * Record the session into an input log that Chip8Batch --replay repeats exactly.
+         * Reseeds the random engine, call before runLoop. Rewinding is disabled while recording
+         * @param filePath: Where the log is written when the window closes
+         */
+        void recordInput(const std::string& filePath);
+
+        /**
+         * Map the host keyboard to the keypad
+         * @param layout: 16 letters or digits, the host keys of chip8 keys 0 to F, e.g. "x123qweasdzc4rfv"
+         * @return: false if the layout is malformed, the keymap is unchanged then
+         */
+        bool setKeymap(const std::string& layout);
+
+        /**
+         * Select the quirk profile the ROM needs, recorded input logs keep it
+         */
+        void setQuirks(QuirkProfile profile);
+
+        /**
+         * UI thread: frame delivery of the last reporting window
+         */
+        const FrameStats& getFrameStats() const;
 
 };
@@ -0,0 +1,54 @@
+#include "SfmlAudioSink.h"
+
+#include <algorithm>
+
+SfmlAudioSink::SfmlAudioSink(unsigned sampleRate) : rate(sampleRate) {
+    initialize(1, sampleRate);
+}
+
+SfmlAudioSink::~SfmlAudioSink() {
+    stop();
+}
+
+unsigned SfmlAudioSink::sampleRate() const {
+    return rate;
+}
+
+void SfmlAudioSink::write(const std::int16_t* samples, std::size_t count) {
+    for(std::size_t i = 0; i < count; i++) {
+        if(!ring.push(samples[i])) {
+            //the device is behind, e.g. in turbo mode, the rest of the chunk is lost
+            overrunCount.fetch_add(count - i, std::memory_order_relaxed);
+            break;
+        }
+    }
+    if(!playing && ring.size() >= PREROLL) {
+        playing = true;
+        play();
+    }
+}
+
+bool SfmlAudioSink::onGetData(Chunk& data) {
+    std::size_t filled = 0;
+    while(filled < chunk.size() && ring.pop(chunk[filled])) {
+        ++filled;
+    }
+    if(filled < chunk.size()) {
+        underrunCount.fetch_add(1, std::memory_order_relaxed);
+        std::fill(chunk.begin() + filled, chunk.end(), 0);
+    }
+    data.samples = chunk.data();
+    data.sampleCount = chunk.size();
+    //keep streaming, an underrun is a glitch and not the end of the sound
+    return true;
+}
+
+void SfmlAudioSink::onSeek(sf::Time) {}
+
+std::uint64_t SfmlAudioSink::underruns() const {
+    return underrunCount.load(std::memory_order_relaxed);
+}
+
+std::uint64_t SfmlAudioSink::overruns() const {
+    return overrunCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <atomic>
+
+#include <SFML/Audio.hpp>
+
+#include "AudioSink.h"
+#include "SpscRing.h"
+
+/**
+ * Plays the samples through SFML.
+ *
+ * SFML pulls audio on a thread of its own, the samples get there through
+ * a second lock-free ring. Playback only starts once PREROLL samples are queued,
+ * after that every chunk SFML asks for and does not get in full counts as an underrun
+ * and is padded with silence.
+ */
+class SfmlAudioSink : public AudioSink, private sf::SoundStream {
+    private:
+        //about 190 ms at 44.1 kHz
+        const static std::size_t RING_SIZE = 8192;
+        //about 46 ms of latency
+        const static std::size_t PREROLL = 2048;
+        const static std::size_t CHUNK_SIZE = 512;
+
+        unsigned rate;
+        SpscRing<std::int16_t, RING_SIZE> ring;
+        std::array<std::int16_t, CHUNK_SIZE> chunk{};
+        bool playing{false};
+
+        std::atomic<std::uint64_t> underrunCount{0};
+        std::atomic<std::uint64_t> overrunCount{0};
+
+        bool onGetData(Chunk& data) override;
+        void onSeek(sf::Time timeOffset) override;
+
+    public:
+        explicit SfmlAudioSink(unsigned sampleRate = 44100);
+        ~SfmlAudioSink() override;
+
+        unsigned sampleRate() const override;
+        void write(const std::int16_t* samples, std::size_t count) override;
+
+        std::uint64_t underruns() const override;
+        std::uint64_t overruns() const override;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <atomic>
+
+/**
+ * Hands the newest value from one writer thread to one reader thread without locks.
+ *
+ * The writer fills its back slot and swaps it with the middle slot on publish(),
+ * the reader swaps the middle slot with its front slot when it holds something newer.
+ * Neither thread ever waits: a value the reader never picked up is overwritten by the next one,
+ * and without a new value the reader keeps the old one.
+ */
+template<typename T>
+class TripleBuffer {
+    private:
+        //index of the middle slot in the low two bits, FRESH while the reader has not taken it
+        const static std::uint8_t FRESH = 0x4;
+
+        std::array<T, 3> slots{};
+        alignas(64) std::atomic<std::uint8_t> middle{1};
+        //only touched by their own thread
+        alignas(64) std::uint8_t back{0};
+        alignas(64) std::uint8_t front{2};
+
+    public:
+        /**
+         * Writer thread only: the slot to fill before publish()
+         */
+        T& writeSlot() {
+            return slots[back];
+        }
+
+        /**
+         * Writer thread only: make the write slot the newest value
+         * @return: false if the previous value was never read, i.e. it was dropped
+         */
+        bool publish() {
+            std::uint8_t previous = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+            back = previous & 0x3u;
+            return !(previous & FRESH);
+        }
+
+        /**
+         * Reader thread only: take the newest value if there is one
+         * @return: false if nothing was published since the last call, readSlot() is unchanged then
+         */
+        bool update() {
+            if(!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+            std::uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+            front = previous & 0x3u;
+            return true;
+        }
+
+        /**
+         * Reader thread only: the value taken by the last update()
+         */
+        const T& readSlot() const {
+            return slots[front];
+        }
+};
@@ -0,0 +1,93 @@
+#include "Profile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "Chip8.h"
+
+void Profile::reset() {
+    *this = Profile{};
+}
+
+std::uint64_t Profile::instructions() const {
+    std::uint64_t total = 0;
+    for(std::uint64_t count : opCounts) total += count;
+    return total;
+}
+
+const char* Profile::opName(Op op) {
+    //without the OP_ prefix
+#define CHIP8_OP_NAME(name) &#name[3],
+    static const char* const names[] = { CHIP8_OPS(CHIP8_OP_NAME) };
+#undef CHIP8_OP_NAME
+    return names[static_cast<std::size_t>(op)];
+}
+
+void Profile::writeJson(std::ostream& out) const {
+    char line[128];
+    std::snprintf(line, sizeof(line), "{\n  \"instructions\": %llu,\n  \"ops\": {", (unsigned long long)instructions());
+    out << line;
+    for(std::size_t i = 0; i < opCounts.size(); i++) {
+        std::snprintf(line, sizeof(line), "%s\n    \"%s\": %llu", i > 0 ? "," : "",
+                      opName(static_cast<Op>(i)), (unsigned long long)opCounts[i]);
+        out << line;
+    }
+    out << "\n  },\n  \"pcs\": [";
+    bool first = true;
+    for(std::size_t pc = 0; pc < pcHits.size(); pc++) {
+        if(pcHits[pc] == 0) continue;
+        std::snprintf(line, sizeof(line), "%s\n    {\"pc\": %zu, \"hits\": %llu}", first ? "" : ",",
+                      pc, (unsigned long long)pcHits[pc]);
+        out << line;
+        first = false;
+    }
+    std::snprintf(line, sizeof(line),
+                  "\n  ],\n  \"pixels_toggled\": %llu,\n  \"collisions\": %llu,\n  \"key_wait_cycles\": %llu\n}\n",
+                  (unsigned long long)pixelsToggled, (unsigned long long)collisions, (unsigned long long)keyWaitCycles);
+    out << line;
+}
+
+void Profile::writeCsv(std::ostream& out) const {
+    char line[64];
+    out << "kind,key,count\n";
+    for(std::size_t i = 0; i < opCounts.size(); i++) {
+        std::snprintf(line, sizeof(line), "op,%s,%llu\n", opName(static_cast<Op>(i)), (unsigned long long)opCounts[i]);
+        out << line;
+    }
+    for(std::size_t pc = 0; pc < pcHits.size(); pc++) {
+        if(pcHits[pc] == 0) continue;
+        std::snprintf(line, sizeof(line), "pc,0x%04zx,%llu\n", pc, (unsigned long long)pcHits[pc]);
+        out << line;
+    }
+    std::snprintf(line, sizeof(line), "counter,pixels_toggled,%llu\n", (unsigned long long)pixelsToggled);
+    out << line;
+    std::snprintf(line, sizeof(line), "counter,collisions,%llu\n", (unsigned long long)collisions);
+    out << line;
+    std::snprintf(line, sizeof(line), "counter,key_wait_cycles,%llu\n", (unsigned long long)keyWaitCycles);
+    out << line;
+}
+
+void Profile::writeFlat(std::ostream& out, const Chip8& chip8) const {
+    std::vector<std::uint16_t> hot;
+    for(std::size_t pc = 0; pc < pcHits.size(); pc++) {
+        if(pcHits[pc] > 0) hot.push_back(static_cast<std::uint16_t>(pc));
+    }
+    std::stable_sort(hot.begin(), hot.end(), [&](std::uint16_t a, std::uint16_t b) {
+        return pcHits[a] > pcHits[b];
+    });
+
+    std::uint64_t total = instructions();
+    double cumulative = 0;
+    char line[128];
+    out << "     %   cumulative          hits      pc  opcode  instruction\n";
+    for(std::uint16_t pc : hot) {
+        double share = total > 0 ? 100.0 * pcHits[pc] / total : 0;
+        cumulative += share;
+        std::uint16_t opcode = chip8.fetch(pc);
+        std::snprintf(line, sizeof(line), "%6.2f %12.2f %13llu  0x%04x  %04x  %s\n",
+                      share, cumulative, (unsigned long long)pcHits[pc], pc, opcode,
+                      opName(chip8.opOf(opcode)));
+        out << line;
+    }
+}
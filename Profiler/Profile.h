@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <ostream>
+#include <vector>
+
+#include "OpTable.h"
+
+//statements that only exist in builds configured with -DCHIP8_PROFILE=ON,
+//everywhere else they compile to nothing
+#ifdef CHIP8_PROFILE
+#define CHIP8_PROFILE_HOOK(statement) statement
+#else
+#define CHIP8_PROFILE_HOOK(statement)
+#endif
+
+struct Chip8;
+
+/**
+ * Execution counters of one Chip8 instance, filled in by the engines
+ * of profiling builds. Idle loops that are fast-forwarded are counted
+ * as if every skipped instruction had been executed
+ */
+struct Profile {
+    //every address a pc can hold, Chip8::MEMORY_SIZE
+    static const std::size_t ADDRESSES = 0x10000;
+
+    //executions per instruction
+    std::array<std::uint64_t, static_cast<std::size_t>(Op::COUNT)> opCounts{};
+    //executions per instruction address, allocated by the first count so instances that are never profiled stay small
+    std::vector<std::uint64_t> pcHits;
+
+    std::uint64_t pixelsToggled{};
+    //DXYN that turned at least one pixel off
+    std::uint64_t collisions{};
+    //FX0A executions that found no key down
+    std::uint64_t keyWaitCycles{};
+
+    void countInstruction(std::uint16_t address, Op op, std::uint64_t times = 1) {
+        opCounts[static_cast<std::size_t>(op)] += times;
+        if(pcHits.empty()) pcHits.resize(ADDRESSES);
+        pcHits[address] += times;
+    }
+
+    void reset();
+
+    std::uint64_t instructions() const;
+
+    /**
+     * Instruction counts, non zero PC hits and the draw and key wait counters
+     */
+    void writeJson(std::ostream& out) const;
+
+    /**
+     * One "kind,key,count" row per counter, kind is op, pc or counter
+     */
+    void writeCsv(std::ostream& out) const;
+
+    /**
+     * Addresses sorted by hits, with their share, the cumulative share and the instruction there
+     * @param chip8: The profiled instance, its memory and quirk profile name the instructions
+     */
+    void writeFlat(std::ostream& out, const Chip8& chip8) const;
+
+    static const char* opName(Op op);
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+#include "Chip8.h"
+
+/**
+ * A basic block translated to C++ by Chip8Recompile
+ */
+struct AotBlock {
+    //the ROM bytes the translation was made from, [begin, end)
+    std::uint16_t begin;
+    std::uint16_t end;
+    //instructions in the block
+    std::uint8_t length;
+    //ends on 1NNN or FX0A, after which the interpreter looks for an idle loop
+    bool idleCheck;
+    //address of every instruction, each one is an entry point
+    const std::uint16_t* addresses;
+    //executes count instructions from instruction entry on and leaves pc at the next one,
+    //count is at most length - entry
+    void (*run)(Chip8& c, unsigned entry, unsigned count);
+};
+
+/**
+ * A whole ROM translated ahead of time, the interface of a generated translation unit
+ */
+struct AotProgram {
+    const char* romName;
+    //the translation is specialized for the instruction semantics of this profile
+    QuirkProfile quirks;
+    const std::uint8_t* rom;
+    std::size_t romSize;
+    //sorted by begin
+    const AotBlock* blocks;
+    std::size_t blockCount;
+};
+
+//defined by the translation unit Chip8Recompile generates
+extern const AotProgram RECOMPILED_PROGRAM;
+
+/**
+ * Generated code: run an instruction without a C++ translation on the interpreter
+ */
+inline void aotInterpret(Chip8& c, std::uint16_t opcode) {
+    c.opcode = opcode;
+    c.executeInstruction();
+}
+
+/**
+ * Generated code: where a taken skip of the extended profiles continues,
+ * F000 NNNN is skipped as a whole like in Chip8::skipNext
+ * @param next: Address after the skip instruction
+ */
+inline std::uint16_t aotSkipExtended(const Chip8& c, std::uint16_t next) {
+    bool longInstruction = c.fetch(next) == 0xF000u;
+    return next + (longInstruction ? 4 : 2);
+}
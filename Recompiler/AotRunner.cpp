@@ -0,0 +1,137 @@
+#include "AotRunner.h"
+
+#include <algorithm>
+#include <cstring>
+
+//profiling builds count every instruction in the interpreter, the translated blocks would bypass the counters
+#ifdef CHIP8_PROFILE
+static const bool NATIVE_SUPPORTED = false;
+#else
+static const bool NATIVE_SUPPORTED = true;
+#endif
+
+AotRunner::AotRunner(Chip8& chip8, const AotProgram& program) : chip8(chip8), program(program) {
+    entryTable.assign(Chip8::MEMORY_SIZE, Entry{nullptr, 0});
+    reset();
+}
+
+void AotRunner::reset() {
+    std::fill(entryTable.begin(), entryTable.end(), Entry{nullptr, 0});
+    validBlocks.assign(program.blockCount, false);
+    //the semantics of the translated instructions were fixed for one profile
+    native = NATIVE_SUPPORTED && chip8.quirks == program.quirks;
+    validate(0, Chip8::MEMORY_SIZE);
+    chip8.clearCodeWrites();
+}
+
+void AotRunner::validate(std::uint32_t begin, std::uint32_t end) {
+    if(!native) return;
+
+    const AotBlock* blocks = program.blocks;
+    const AotBlock* blocksEnd = program.blocks + program.blockCount;
+    //blocks are sorted by begin and never longer than MAX_BLOCK_BYTES
+    auto firstOverlapping = [&](std::uint32_t address) {
+        std::uint32_t first = address > MAX_BLOCK_BYTES ? address - MAX_BLOCK_BYTES : 0;
+        return std::lower_bound(blocks, blocksEnd, first, [](const AotBlock& b, std::uint32_t a) { return b.begin < a; });
+    };
+
+    //the blocks with written bytes, and the range their instructions cover
+    std::uint32_t low = end;
+    std::uint32_t high = begin;
+    for(const AotBlock* block = firstOverlapping(begin); block != blocksEnd && block->begin < end; ++block) {
+        if(block->end <= begin) continue;
+
+        std::size_t i = block - blocks;
+        const std::uint8_t* original = program.rom + (block->begin - Chip8::start_address);
+        //rewritten code that was restored is valid again
+        bool valid = std::memcmp(&chip8.memory[block->begin], original, block->end - block->begin) == 0;
+        if(validBlocks[i] && !valid) ++stats.blocksInvalidated;
+        validBlocks[i] = valid;
+        low = std::min<std::uint32_t>(low, block->begin);
+        high = std::max<std::uint32_t>(high, block->end);
+    }
+    if(low >= high) return;
+
+    //every valid block with instructions in the range competes for their entries again
+    std::fill(entryTable.begin() + low, entryTable.begin() + high, Entry{nullptr, 0});
+    for(const AotBlock* block = firstOverlapping(low); block != blocksEnd && block->begin < high; ++block) {
+        if(!validBlocks[block - blocks] || block->end <= low) continue;
+
+        for(std::uint8_t k = 0; k < block->length; k++) {
+            std::uint16_t address = block->addresses[k];
+            if(address < low || address >= high) continue;
+            Entry& entry = entryTable[address];
+            if(entry.block == nullptr || entry.block->length - entry.index < block->length - k) {
+                entry = {block, k};
+            }
+        }
+    }
+}
+
+void AotRunner::checkCodeWrites() {
+    if(chip8.codeWriteBegin >= chip8.codeWriteEnd) return;
+    validate(chip8.codeWriteBegin, chip8.codeWriteEnd);
+    chip8.clearCodeWrites();
+}
+
+void AotRunner::run(std::uint64_t cycles) {
+    std::unique_ptr<Chip8> shadow;
+    if(verify) shadow = std::make_unique<Chip8>(chip8);
+
+    std::uint64_t remaining = cycles;
+    while(remaining > 0) {
+        const Entry& entry = entryTable[chip8.pc];
+        std::uint16_t blockPc = chip8.pc;
+        std::uint64_t executed;
+        bool idleCheck;
+
+        if(entry.block != nullptr) {
+            //as much of the block as the budget allows
+            std::uint64_t available = entry.block->length - entry.index;
+            executed = std::min(available, remaining);
+            entry.block->run(chip8, entry.index, static_cast<unsigned>(executed));
+            chip8.cycleCount += executed;
+            stats.nativeInstructions += executed;
+            idleCheck = executed == available && entry.block->idleCheck;
+        }
+        else {
+            chip8.cycle();
+            executed = 1;
+            ++stats.interpretedInstructions;
+            idleCheck = (chip8.opcode & 0xF000u) == 0x1000u || (chip8.opcode & 0xF0FFu) == 0xF00Au;
+        }
+        remaining -= executed;
+
+        checkCodeWrites();
+
+        //the interpreter fast-forwards idle loops after the same instructions
+        std::uint64_t beforeIdle = remaining;
+        if(idleCheck && chip8.skipIdle(remaining)) {
+            chip8.cycleCount += beforeIdle - remaining;
+        }
+
+        if(verify) {
+            for(std::uint64_t i = 0; i < executed; i++) {
+                shadow->cycle();
+            }
+            if(idleCheck) {
+                std::uint64_t shadowRemaining = beforeIdle;
+                if(shadow->skipIdle(shadowRemaining)) shadow->cycleCount += beforeIdle - shadowRemaining;
+            }
+            if(shadow->registersHash() != chip8.registersHash() ||
+               shadow->memoryHash() != chip8.memoryHash() ||
+               shadow->displayHash() != chip8.displayHash()) {
+                if(stats.mismatches++ == 0) stats.firstMismatchPc = blockPc;
+                shadow = std::make_unique<Chip8>(chip8);
+            }
+        }
+    }
+}
+
+void AotRunner::setVerify(bool enabled) {
+    verify = enabled;
+}
+
+const AotStats& AotRunner::getStats() const {
+    return stats;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "AotProgram.h"
+#include "Chip8.h"
+
+struct AotStats {
+    std::uint64_t nativeInstructions{};
+    std::uint64_t interpretedInstructions{};
+    //blocks dropped because the ROM overwrote the bytes they were translated from
+    std::uint64_t blocksInvalidated{};
+
+    //set by the verifying run, blocks whose result differed from Chip8::cycle
+    std::uint64_t mismatches{};
+    std::uint16_t firstMismatchPc{};
+};
+
+/**
+ * Runs a Chip8 on the blocks of a ROM translated ahead of time.
+ *
+ * Every pc inside a valid block runs the block's C++ translation from there, everything else
+ * (code only reached through BNNN, code outside the ROM) runs on the interpreter
+ * one instruction at a time.
+ * A block is only valid while memory still holds the bytes it was translated from,
+ * so self-modifying ROMs fall back to the interpreter for the code they rewrote.
+ *
+ * Programs translated under another quirk profile than the Chip8's, and profiling builds, only interpret.
+ */
+class AotRunner {
+    private:
+        //the longest block in bytes, 64 instructions of up to 4 bytes
+        const static std::uint16_t MAX_BLOCK_BYTES = 256;
+
+        //a valid block containing an instruction at some address
+        struct Entry {
+            const AotBlock* block;
+            std::uint8_t index;
+        };
+
+        Chip8& chip8;
+        const AotProgram& program;
+        bool native;
+
+        //whether the bytes of each block of the program still match the ROM
+        std::vector<bool> validBlocks;
+        //indexed by the whole 16-bit pc range, the longest valid run of translated code from there
+        std::vector<Entry> entryTable;
+
+        bool verify{false};
+        AotStats stats;
+
+        /**
+         * Check the blocks overlapping [begin, end) against the ROM and rebuild the entries they provide
+         */
+        void validate(std::uint32_t begin, std::uint32_t end);
+        void checkCodeWrites();
+
+    public:
+        /**
+         * @param chip8: Must outlive the runner, with the program's ROM loaded
+         * @param program: Usually RECOMPILED_PROGRAM
+         */
+        AotRunner(Chip8& chip8, const AotProgram& program);
+
+        /**
+         * Execute exactly the given number of instructions
+         */
+        void run(std::uint64_t cycles);
+
+        /**
+         * Check all blocks again, needed after the memory was replaced from outside (e.g. loadRom, loadState)
+         * or the quirk profile changed
+         */
+        void reset();
+
+        /**
+         * Check every block against a shadow interpreter, mismatches are counted in the stats
+         */
+        void setVerify(bool enabled);
+
+        const AotStats& getStats() const;
+};
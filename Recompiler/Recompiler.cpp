@@ -0,0 +1,377 @@
+#include "Recompiler.h"
+
+#include <cstdio>
+#include <set>
+
+namespace {
+
+    /**
+     * printf into a std::string, the generated lines are short
+     */
+    template<typename... Args>
+    std::string format(const char* pattern, Args... args) {
+        char line[160];
+        std::snprintf(line, sizeof(line), pattern, args...);
+        return line;
+    }
+
+    std::string reg(std::uint8_t x) {
+        return format("c.registers[0x%X]", x);
+    }
+
+    const char* enumName(QuirkProfile profile) {
+        switch(profile) {
+            case QuirkProfile::Cosmac: return "QuirkProfile::Cosmac";
+            case QuirkProfile::SuperChip: return "QuirkProfile::SuperChip";
+            case QuirkProfile::XoChip: return "QuirkProfile::XoChip";
+            default: return "QuirkProfile::Default";
+        }
+    }
+
+    struct Semantics {
+        bool vfReset;
+        bool shiftVx;
+        bool jumpVx;
+        bool extended;
+        bool memoryIncrement;
+        std::uint16_t addressMask;
+    };
+
+    template<typename Quirks>
+    Semantics semanticsOf() {
+        return {Quirks::vfReset, Quirks::shiftVx, Quirks::jumpVx, Quirks::extended, Quirks::memoryIncrement, Quirks::addressMask};
+    }
+
+}
+
+Recompiler::Recompiler(const Chip8& chip8) : chip8(chip8) {
+    romEnd = Chip8::start_address + chip8.program_size;
+
+    Semantics semantics;
+    switch(chip8.quirks) {
+        case QuirkProfile::Cosmac: semantics = semanticsOf<CosmacQuirks>(); break;
+        case QuirkProfile::SuperChip: semantics = semanticsOf<SuperChipQuirks>(); break;
+        case QuirkProfile::XoChip: semantics = semanticsOf<XoChipQuirks>(); break;
+        default: semantics = semanticsOf<DefaultQuirks>(); break;
+    }
+    vfReset = semantics.vfReset;
+    shiftVx = semantics.shiftVx;
+    jumpVx = semantics.jumpVx;
+    extended = semantics.extended;
+    memoryIncrement = semantics.memoryIncrement;
+    addressMask = semantics.addressMask;
+}
+
+bool Recompiler::inRom(std::uint32_t address) const {
+    return address >= Chip8::start_address && address + 2 <= romEnd;
+}
+
+Recompiler::Block Recompiler::translate(std::uint16_t address, std::vector<std::uint16_t>& successors) {
+    Block block{};
+    block.begin = address;
+    //the statements of the instruction being translated
+    std::vector<std::string> lines;
+
+    std::uint32_t addr = address;
+    bool terminator = false;
+
+    //pc = condition ? skip : next, the extended profiles skip F000 NNNN as a whole
+    auto conditionalSkip = [&](const std::string& condition, std::uint16_t next) {
+        if(extended) {
+            lines.push_back(format("c.pc = %s ? aotSkipExtended(c, 0x%04X) : 0x%04X;", condition.c_str(), next, next));
+            if(chip8.fetch(next) == 0xF000u) successors.push_back(next + 4);
+        }
+        else {
+            lines.push_back(format("c.pc = %s ? 0x%04X : 0x%04X;", condition.c_str(), next + 2, next));
+        }
+        successors.push_back(next);
+        successors.push_back(next + 2);
+        terminator = true;
+    };
+
+    auto interpret = [&](std::uint16_t opcode) {
+        lines.push_back(format("aotInterpret(c, 0x%04X);", opcode));
+        ++stats.interpretedInstructions;
+    };
+
+    while(block.instructions.size() < MAX_BLOCK_LENGTH && inRom(addr)) {
+        std::uint16_t opcode = (chip8.memory[addr] << 8u) | chip8.memory[addr + 1];
+        Chip8::Operands a = Chip8::splitOperands(opcode);
+        Op op = chip8.opOf(opcode);
+        std::uint16_t next = addr + 2;
+
+        //the address is the next word, the whole instruction has to be in the ROM
+        if(op == Op::OP_F000 && next + 2u > romEnd) break;
+
+        lines.push_back(format("//%04X: %04X", addr, opcode));
+        std::uint16_t instructionAddress = addr;
+        switch(op) {
+            case Op::OP_00EE:
+                lines.push_back("--c.sp;");
+                lines.push_back("c.pc = c.stack[c.sp & 0xFu];");
+                terminator = true;
+                break;
+            case Op::OP_1NNN:
+                lines.push_back(format("c.pc = 0x%04X;", a.nnn));
+                successors.push_back(a.nnn);
+                terminator = true;
+                break;
+            case Op::OP_2NNN:
+                lines.push_back(format("c.stack[c.sp++ & 0xFu] = 0x%04X;", next));
+                lines.push_back(format("c.pc = 0x%04X;", a.nnn));
+                successors.push_back(a.nnn);
+                //the return lands here
+                successors.push_back(next);
+                terminator = true;
+                break;
+            case Op::OP_3XNN: conditionalSkip(format("%s == 0x%02X", reg(a.x).c_str(), a.nn), next); break;
+            case Op::OP_4XNN: conditionalSkip(format("%s != 0x%02X", reg(a.x).c_str(), a.nn), next); break;
+            case Op::OP_5XY0: conditionalSkip(reg(a.x) + " == " + reg(a.y), next); break;
+            case Op::OP_9XY0: conditionalSkip(reg(a.x) + " != " + reg(a.y), next); break;
+            case Op::OP_EX9E: conditionalSkip("c.keyPad[" + reg(a.x) + " & 0xF]", next); break;
+            case Op::OP_EXA1: conditionalSkip("!c.keyPad[" + reg(a.x) + " & 0xF]", next); break;
+            case Op::OP_6XNN:
+                lines.push_back(format("%s = 0x%02X;", reg(a.x).c_str(), a.nn));
+                break;
+            case Op::OP_7XNN:
+                lines.push_back(format("%s += 0x%02X;", reg(a.x).c_str(), a.nn));
+                break;
+            case Op::OP_8XY0:
+                lines.push_back(reg(a.x) + " = " + reg(a.y) + ";");
+                break;
+            case Op::OP_8XY1:
+            case Op::OP_8XY2:
+            case Op::OP_8XY3: {
+                const char* alu = op == Op::OP_8XY1 ? " | " : op == Op::OP_8XY2 ? " & " : " ^ ";
+                lines.push_back(reg(a.x) + " = " + reg(a.x) + alu + reg(a.y) + ";");
+                if(vfReset) lines.push_back("c.registers[0xF] = 0;");
+                break;
+            }
+            //VF is written before VX in the same order as the interpreter, which matters when X is F
+            case Op::OP_8XY4:
+                lines.push_back("{");
+                lines.push_back("    std::uint16_t result = " + reg(a.x) + " + " + reg(a.y) + ";");
+                lines.push_back("    c.registers[0xF] = result > 0xFF;");
+                lines.push_back("    " + reg(a.x) + " = result & 0xFF;");
+                lines.push_back("}");
+                break;
+            case Op::OP_8XY5:
+                lines.push_back("c.registers[0xF] = " + reg(a.x) + " > " + reg(a.y) + ";");
+                lines.push_back(reg(a.x) + " -= " + reg(a.y) + ";");
+                break;
+            case Op::OP_8XY7:
+                lines.push_back("c.registers[0xF] = " + reg(a.y) + " > " + reg(a.x) + ";");
+                lines.push_back(reg(a.x) + " = " + reg(a.y) + " - " + reg(a.x) + ";");
+                break;
+            case Op::OP_8XY6: {
+                std::uint8_t source = shiftVx ? a.x : a.y;
+                lines.push_back(reg(a.x) + " = " + reg(source) + " >> 1;");
+                lines.push_back("c.registers[0xF] = " + reg(source) + " & 0x01;");
+                break;
+            }
+            case Op::OP_8XYE: {
+                std::uint8_t source = shiftVx ? a.x : a.y;
+                lines.push_back(reg(a.x) + " = " + reg(source) + " << 1;");
+                lines.push_back("c.registers[0xF] = (" + reg(source) + " & 0x80) >> 7;");
+                break;
+            }
+            case Op::OP_ANNN:
+                lines.push_back(format("c.vi = 0x%04X;", a.nnn));
+                break;
+            case Op::OP_BNNN:
+                lines.push_back(format("c.pc = 0x%04X + %s;", a.nnn, reg(jumpVx ? a.x : 0).c_str()));
+                ++stats.computedJumps;
+                terminator = true;
+                break;
+            case Op::OP_CXNN:
+                lines.push_back(format("%s = static_cast<std::uint8_t>(c.randomEngine() >> 56u) & 0x%02X;", reg(a.x).c_str(), a.nn));
+                break;
+            case Op::OP_FX65:
+                lines.push_back(format("for(unsigned i = 0; i <= 0x%X; i++) {", a.x));
+                lines.push_back(format("    c.registers[i] = c.memory[(c.vi + i) & 0x%04X];", addressMask));
+                lines.push_back("}");
+                if(memoryIncrement) lines.push_back(format("c.vi += 0x%X;", a.x + 1));
+                break;
+            case Op::OP_FX07:
+                lines.push_back(reg(a.x) + " = c.delay_timer;");
+                break;
+            case Op::OP_FX15:
+                lines.push_back("c.delay_timer = " + reg(a.x) + ";");
+                break;
+            case Op::OP_FX18:
+                lines.push_back("c.sound_timer = " + reg(a.x) + ";");
+                break;
+            case Op::OP_FX1E:
+                lines.push_back("c.vi += " + reg(a.x) + ";");
+                break;
+            case Op::OP_FX29:
+                lines.push_back(format("c.vi = 0x%04X + 5 * %s;", Chip8::fontset_start_address, reg(a.x).c_str()));
+                break;
+            //these read pc: the key wait and the exit rewind it, F000 steps over its address
+            case Op::OP_FX0A:
+            case Op::OP_00FD:
+            case Op::OP_F000:
+                lines.push_back(format("c.pc = 0x%04X;", next));
+                interpret(opcode);
+                if(op == Op::OP_F000) {
+                    next += 2;
+                    break;
+                }
+                if(op == Op::OP_FX0A) successors.push_back(next);
+                terminator = true;
+                break;
+            //may overwrite code, the runner checks the written bytes before the next block
+            case Op::OP_FX33:
+                lines.push_back("{");
+                lines.push_back("    std::uint8_t value = " + reg(a.x) + ";");
+                lines.push_back(format("    c.memory[c.vi & 0x%04X] = value / 100;", addressMask));
+                lines.push_back(format("    c.memory[(c.vi + 1) & 0x%04X] = value / 10 %% 10;", addressMask));
+                lines.push_back(format("    c.memory[(c.vi + 2) & 0x%04X] = value %% 10;", addressMask));
+                lines.push_back("}");
+                lines.push_back(format("c.invalidateCode(c.vi, 3, 0x%04X);", addressMask));
+                lines.push_back(format("c.pc = 0x%04X;", next));
+                successors.push_back(next);
+                terminator = true;
+                break;
+            case Op::OP_FX55:
+                lines.push_back(format("for(unsigned i = 0; i <= 0x%X; i++) {", a.x));
+                lines.push_back(format("    c.memory[(c.vi + i) & 0x%04X] = c.registers[i];", addressMask));
+                lines.push_back("}");
+                lines.push_back(format("c.invalidateCode(c.vi, 0x%X, 0x%04X);", a.x + 1, addressMask));
+                if(memoryIncrement) lines.push_back(format("c.vi += 0x%X;", a.x + 1));
+                lines.push_back(format("c.pc = 0x%04X;", next));
+                successors.push_back(next);
+                terminator = true;
+                break;
+            case Op::OP_5XY2:
+                lines.push_back(format("c.pc = 0x%04X;", next));
+                interpret(opcode);
+                successors.push_back(next);
+                terminator = true;
+                break;
+            case Op::OP_NULL:
+                break;
+            //00E0, DXYN and most extended instructions
+            default:
+                interpret(opcode);
+                break;
+        }
+
+        block.instructions.push_back({instructionAddress, std::move(lines)});
+        lines.clear();
+        addr = next;
+        if(terminator) {
+            block.idleCheck = op == Op::OP_1NNN || op == Op::OP_FX0A;
+            break;
+        }
+    }
+
+    if(!terminator && !block.instructions.empty()) {
+        block.instructions.back().lines.push_back(format("c.pc = 0x%04X;", addr));
+        successors.push_back(addr);
+    }
+    block.end = addr;
+    return block;
+}
+
+void Recompiler::analyze() {
+    blocks.clear();
+    stats = RecompilerStats{};
+
+    std::vector<std::uint16_t> pending = {Chip8::start_address};
+    while(!pending.empty()) {
+        std::uint16_t address = pending.back();
+        pending.pop_back();
+        if(!inRom(address) || blocks.count(address)) continue;
+
+        std::vector<std::uint16_t> successors;
+        Block block = translate(address, successors);
+        //F000 as the last word of the ROM
+        if(block.instructions.empty()) continue;
+
+        stats.instructions += block.instructions.size();
+        blocks.emplace(address, std::move(block));
+        pending.insert(pending.end(), successors.begin(), successors.end());
+    }
+
+    //a jump into the middle of a block starts a block of its own, the bytes are counted once
+    std::set<std::uint16_t> reached;
+    for(const auto& entry : blocks) {
+        for(std::uint32_t i = entry.second.begin; i < entry.second.end; i++) reached.insert(i);
+    }
+    stats.blocks = blocks.size();
+    stats.reachedBytes = reached.size();
+}
+
+void Recompiler::emit(std::ostream& out, const std::string& romName) const {
+    out << "//generated by Chip8Recompile from " << romName << ", do not edit\n";
+    out << "#include \"AotProgram.h\"\n\n";
+    out << "namespace {\n\n";
+
+    out << "    const std::uint8_t ROM[] = {";
+    for(std::uint32_t i = Chip8::start_address; i < romEnd; i++) {
+        if((i - Chip8::start_address) % 16 == 0) out << "\n           ";
+        out << format(" 0x%02X,", chip8.memory[i]);
+    }
+    out << "\n    };\n\n";
+
+    for(const auto& entry : blocks) {
+        const Block& block = entry.second;
+
+        out << format("    const std::uint16_t ADDRESSES_%04X[] = {", block.begin);
+        for(std::size_t i = 0; i < block.instructions.size(); i++) {
+            out << (i % 8 == 0 ? "\n           " : "") << format(" 0x%04X,", block.instructions[i].address);
+        }
+        out << "\n    };\n\n";
+
+        //a single instruction has nothing to select and can not stop early
+        bool single = block.instructions.size() == 1;
+        out << format("    void block_%04X(Chip8& c, unsigned%s, unsigned%s) {\n",
+                      block.begin, single ? "" : " entry", single ? "" : " count");
+        if(!single) out << "        switch(entry) {\n";
+        const char* indent = single ? "        " : "                ";
+        for(std::size_t i = 0; i < block.instructions.size(); i++) {
+            const Instruction& instruction = block.instructions[i];
+            if(!single) out << format("            case %zu:\n", i);
+            for(const std::string& line : instruction.lines) {
+                out << indent << line << "\n";
+            }
+            //stop when the budget is used up, the last instruction has set pc itself
+            if(i + 1 < block.instructions.size()) {
+                out << indent << "if(--count == 0) {\n";
+                out << indent << format("    c.pc = 0x%04X;\n", block.instructions[i + 1].address);
+                out << indent << "    return;\n";
+                out << indent << "}\n";
+                out << indent << "[[fallthrough]];\n";
+            }
+        }
+        if(!single) out << "        }\n";
+        out << "    }\n\n";
+    }
+
+    out << "    const AotBlock BLOCKS[] = {\n";
+    for(const auto& entry : blocks) {
+        const Block& block = entry.second;
+        out << format("        {0x%04X, 0x%04X, %zu, %s, ADDRESSES_%04X, &block_%04X},\n",
+                      block.begin, block.end, block.instructions.size(), block.idleCheck ? "true" : "false",
+                      block.begin, block.begin);
+    }
+    out << "    };\n\n";
+    out << "}\n\n";
+
+    std::string name;
+    for(char c : romName) {
+        if(c == '"' || c == '\\') name += '\\';
+        name += c;
+    }
+    out << "extern const AotProgram RECOMPILED_PROGRAM = {\n";
+    out << "    \"" << name << "\",\n";
+    out << "    " << enumName(chip8.quirks) << ",\n";
+    out << "    ROM, sizeof(ROM),\n";
+    out << "    BLOCKS, sizeof(BLOCKS) / sizeof(BLOCKS[0])\n";
+    out << "};\n";
+}
+
+const RecompilerStats& Recompiler::getStats() const {
+    return stats;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Chip8.h"
+
+struct RecompilerStats {
+    std::size_t blocks{};
+    std::size_t instructions{};
+    //instructions whose translation calls the interpreter (e.g. 00E0, DXYN, FX0A)
+    std::size_t interpretedInstructions{};
+    //ROM bytes covered by at least one block, the rest is data or only reachable through BNNN
+    std::size_t reachedBytes{};
+    //BNNN jumps, their targets are left to the interpreter
+    std::size_t computedJumps{};
+};
+
+/**
+ * Ahead-of-time translator from a ROM to C++.
+ *
+ * Recovers the control flow graph by following every static successor
+ * (jumps, calls and their return addresses, both sides of every skip) from start_address,
+ * and translates each basic block into one C++ function with the semantics of the
+ * selected quirk profile compiled in. Blocks end where control flow leaves statically
+ * unknown (00EE, BNNN, FX0A), and after instructions that write memory (FX33, FX55, 5XY2)
+ * so the runner can drop code the ROM rewrote. Instructions that are not worth
+ * translating call back into the interpreter.
+ *
+ * A block's function can be entered at any of its instructions and left after any number
+ * of them, so an instruction budget that ends mid-block does not leave translated code.
+ *
+ * The emitted translation unit defines RECOMPILED_PROGRAM, see AotRunner.
+ */
+class Recompiler {
+    private:
+        //longest block in instructions
+        const static unsigned MAX_BLOCK_LENGTH = 64;
+
+        struct Instruction {
+            std::uint16_t address;
+            std::vector<std::string> lines;
+        };
+
+        struct Block {
+            std::uint16_t begin;
+            std::uint16_t end;
+            bool idleCheck;
+            //every instruction is an entry point of the block's function
+            std::vector<Instruction> instructions;
+        };
+
+        const Chip8& chip8;
+        std::uint32_t romEnd;
+
+        //the quirks the translated instructions are specialized for
+        bool vfReset;
+        bool shiftVx;
+        bool jumpVx;
+        bool extended;
+        bool memoryIncrement;
+        std::uint16_t addressMask;
+
+        std::map<std::uint16_t, Block> blocks;
+        RecompilerStats stats;
+
+        /**
+         * Translate the block starting at address
+         * @param successors: Receives the statically known addresses control can continue at
+         */
+        Block translate(std::uint16_t address, std::vector<std::uint16_t>& successors);
+
+        bool inRom(std::uint32_t address) const;
+
+    public:
+        /**
+         * @param chip8: A freshly loaded ROM with the quirk profile it runs under, read only
+         */
+        explicit Recompiler(const Chip8& chip8);
+
+        /**
+         * Recover the blocks reachable from start_address
+         */
+        void analyze();
+
+        /**
+         * Write the translation unit
+         * @param romName: Stored in the program for reports
+         */
+        void emit(std::ostream& out, const std::string& romName) const;
+
+        const RecompilerStats& getStats() const;
+};
@@ -0,0 +1,80 @@
+#include "InputLog.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+bool InputLog::load(const std::string& filePath) {
+    std::ifstream file(filePath);
+    if(!file.is_open()) return false;
+
+    *this = InputLog{};
+
+    std::string line;
+    while(std::getline(file, line)) {
+        if(line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string first;
+        fields >> first;
+
+        if(first == "seed") {
+            if(!(fields >> std::hex >> seed)) return false;
+            hasSeed = true;
+        }
+        else if(first == "frequency") {
+            if(!(fields >> frequency) || frequency <= 0) return false;
+        }
+        else if(first == "quirks") {
+            std::string name;
+            if(!(fields >> name) || !parseQuirkProfile(name, quirks)) return false;
+            hasQuirks = true;
+        }
+        else if(first == "end") {
+            if(!(fields >> endCycle)) return false;
+            hasEnd = true;
+        }
+        else if(first == "expect") {
+            if(!(fields >> std::hex >> registersHash >> memoryHash >> displayHash)) return false;
+            hasExpected = true;
+        }
+        else {
+            std::istringstream event(line);
+            std::uint64_t cycle;
+            unsigned key;
+            std::string state;
+            if(!(event >> cycle >> std::hex >> key >> state) || key > 0xF) return false;
+            if(state != "down" && state != "up") return false;
+
+            events.push_back({cycle, static_cast<std::uint8_t>(key), state == "down"});
+        }
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const InputEvent& a, const InputEvent& b) {
+        return a.cycle < b.cycle;
+    });
+    return true;
+}
+
+bool InputLog::save(const std::string& filePath) const {
+    std::FILE* file = std::fopen(filePath.c_str(), "w");
+    if(file == nullptr) return false;
+
+    std::fprintf(file, "# chip8 input log\n");
+    if(hasSeed) std::fprintf(file, "seed %llx\n", (unsigned long long)seed);
+    if(frequency > 0) std::fprintf(file, "frequency %.17g\n", frequency);
+    if(hasQuirks) std::fprintf(file, "quirks %s\n", quirkProfileName(quirks));
+    for(const InputEvent& event : events) {
+        std::fprintf(file, "%llu %x %s\n", (unsigned long long)event.cycle, event.key, event.pressed ? "down" : "up");
+    }
+    if(hasEnd) std::fprintf(file, "end %llu\n", (unsigned long long)endCycle);
+    if(hasExpected) {
+        std::fprintf(file, "expect %016llx %016llx %016llx\n",
+                     (unsigned long long)registersHash,
+                     (unsigned long long)memoryHash,
+                     (unsigned long long)displayHash);
+    }
+
+    return std::fclose(file) == 0;
+}
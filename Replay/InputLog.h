@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Quirks.h"
+
+/**
+ * A keypad change scheduled before the given instruction cycle
+ */
+struct InputEvent {
+    std::uint64_t cycle;
+    std::uint8_t key;
+    bool pressed;
+};
+
+/**
+ * Everything needed to repeat a session bit for bit: the seed, the clock and
+ * every keypad change stamped with Chip8::cycleCount, optionally followed by
+ * where the recording ended and the state hashes it ended with.
+ *
+ * Text format, one entry per line, '#' starts a comment:
+ *   seed <hex>
+ *   frequency <hz>
+ *   quirks <default|chip8|schip|xochip>
+ *   <cycle> <hex key> down|up
+ *   end <cycle>
+ *   expect <registers hash> <memory hash> <display hash>
+ *
+ * A file with only event lines is a plain input script.
+ */
+struct InputLog {
+    bool hasSeed{false};
+    std::uint64_t seed{};
+
+    //0 if the log does not fix the clock
+    double frequency{};
+
+    bool hasQuirks{false};
+    QuirkProfile quirks{QuirkProfile::Default};
+
+    //sorted by cycle
+    std::vector<InputEvent> events;
+
+    bool hasEnd{false};
+    std::uint64_t endCycle{};
+
+    bool hasExpected{false};
+    std::uint64_t registersHash{};
+    std::uint64_t memoryHash{};
+    std::uint64_t displayHash{};
+
+    /**
+     * @return false if the file can not be read or a line is malformed
+     */
+    bool load(const std::string& filePath);
+
+    /**
+     * @return false if the file can not be written
+     */
+    bool save(const std::string& filePath) const;
+};
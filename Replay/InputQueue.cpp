@@ -0,0 +1,34 @@
+#include "InputQueue.h"
+
+#include <algorithm>
+
+void InputQueue::push(const InputEvent& event) {
+    pending.push_back(event);
+}
+
+void InputQueue::applyDue(Chip8& chip8) {
+    while(!pending.empty() && pending.front().cycle <= chip8.cycleCount) {
+        chip8.keyPad[pending.front().key & 0xFu] = pending.front().pressed;
+        pending.pop_front();
+    }
+}
+
+void InputQueue::run(Chip8& chip8, std::uint64_t cycles, const std::function<void(std::uint64_t)>& execute) {
+    std::uint64_t end = chip8.cycleCount + cycles;
+    while(chip8.cycleCount < end) {
+        applyDue(chip8);
+
+        //run uninterrupted up to the next event
+        std::uint64_t until = end;
+        if(!pending.empty()) until = std::min(until, pending.front().cycle);
+        execute(until - chip8.cycleCount);
+    }
+}
+
+std::size_t InputQueue::size() const {
+    return pending.size();
+}
+
+void InputQueue::clear() {
+    pending.clear();
+}
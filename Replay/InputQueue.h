@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <functional>
+
+#include "Chip8.h"
+#include "InputLog.h"
+
+/**
+ * Keypad events waiting for the instruction cycle they are due at.
+ *
+ * run() executes a slice of instructions in runs that stop exactly at the next event,
+ * so every change reaches the keypad before the instruction at its cycle
+ * (Chip8::cycleCount), however the instructions are executed. Replays of recorded logs
+ * and the live frontend go through the same path, which is what makes a live
+ * session repeat bit for bit headless.
+ */
+class InputQueue {
+    private:
+        std::deque<InputEvent> pending;
+
+    public:
+        /**
+         * Events must arrive in cycle order, an event for a cycle that already ran
+         * is applied before the next instruction
+         */
+        void push(const InputEvent& event);
+
+        /**
+         * Execute exactly the given number of instructions, applying every event that falls due
+         * @param execute: Runs n instructions on chip8, e.g. Chip8::run or Jit::run
+         */
+        void run(Chip8& chip8, std::uint64_t cycles, const std::function<void(std::uint64_t)>& execute);
+
+        /**
+         * Apply every event due at or before the current cycle without running anything
+         */
+        void applyDue(Chip8& chip8);
+
+        std::size_t size() const;
+        void clear();
+};
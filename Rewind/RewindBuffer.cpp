@@ -0,0 +1,157 @@
+#include "RewindBuffer.h"
+
+#include <cstring>
+
+#include "Rle.h"
+
+RewindBuffer::RewindBuffer(std::size_t capacity, std::size_t keyframeInterval)
+        : capacity(capacity), keyframeInterval(keyframeInterval > 0 ? keyframeInterval : 1) {
+    scratch.resize(Chip8::coreStateSize());
+}
+
+void RewindBuffer::capture(Chip8& chip8) {
+    if(capacity == 0) return;
+
+    if(groups.empty() || groups.back().frames.size() >= keyframeInterval) {
+        //drop the oldest group once full, its deltas are useless without the keyframe
+        if(frames + 1 > capacity && !groups.empty()) {
+            frames -= groups.front().frames.size();
+            spareGroups.push_back(std::move(groups.front()));
+            groups.pop_front();
+        }
+
+        Group group;
+        if(!spareGroups.empty()) {
+            group = std::move(spareGroups.back());
+            spareGroups.pop_back();
+            group.frames.clear();
+        }
+        groups.push_back(std::move(group));
+    }
+
+    Group& group = groups.back();
+    Frame frame;
+    if(group.frames.empty()) {
+        frame.state.resize(Chip8::coreStateSize());
+        chip8.saveCoreState(frame.state.data());
+    }
+    else {
+        chip8.saveCoreState(scratch.data());
+        const std::vector<std::uint8_t>& keyframe = group.frames.front().state;
+        for(std::size_t i = 0; i < scratch.size(); i++) {
+            scratch[i] ^= keyframe[i];
+        }
+        Rle::encode(scratch.data(), scratch.size(), frame.state);
+        frame.state.shrink_to_fit();
+    }
+    captureMemory(chip8, frame.undo);
+    group.frames.push_back(std::move(frame));
+    ++frames;
+}
+
+void RewindBuffer::captureMemory(Chip8& chip8, std::vector<std::uint8_t>& undo) {
+    if(memory.empty()) {
+        memory.assign(chip8.memory.begin(), chip8.memory.end());
+    }
+    else {
+        //setQuirks gave the machine XO-CHIP's 64 KB, what came into reach is empty
+        if(memory.size() < chip8.memory.size()) {
+            memory.resize(chip8.memory.size(), 0);
+        }
+        //pages that were not written since the last capture still match the stored memory
+        for(std::size_t word = 0; word < chip8.writtenPages.size(); word++) {
+            for(std::uint64_t bits = chip8.writtenPages[word]; bits != 0; bits &= bits - 1) {
+                std::size_t p = word * 64 + __builtin_ctzll(bits);
+                std::uint8_t* stored = &memory[p * PAGE_SIZE];
+                const std::uint8_t* current = &chip8.memory[p * PAGE_SIZE];
+                if(std::memcmp(stored, current, PAGE_SIZE) == 0) continue;
+
+                undo.push_back(static_cast<std::uint8_t>(p));
+                undo.insert(undo.end(), stored, stored + PAGE_SIZE);
+                std::memcpy(stored, current, PAGE_SIZE);
+            }
+        }
+        undo.shrink_to_fit();
+    }
+    chip8.clearWrittenPages();
+}
+
+void RewindBuffer::restoreMemory(Chip8& chip8, const std::vector<std::uint8_t>& undo) {
+    //back to the stored memory, only what was written since the last capture or step can differ
+    for(std::size_t word = 0; word < chip8.writtenPages.size(); word++) {
+        for(std::uint64_t bits = chip8.writtenPages[word]; bits != 0; bits &= bits - 1) {
+            std::size_t p = word * 64 + __builtin_ctzll(bits);
+            const std::uint8_t* stored = &memory[p * PAGE_SIZE];
+            std::uint8_t* current = &chip8.memory[p * PAGE_SIZE];
+            if(std::memcmp(stored, current, PAGE_SIZE) == 0) continue;
+
+            std::memcpy(current, stored, PAGE_SIZE);
+            //decoded and compiled code of the old bytes
+            chip8.invalidateCode(p * PAGE_SIZE, PAGE_SIZE);
+        }
+    }
+    chip8.clearWrittenPages();
+
+    //the stored memory steps back to the frame before, the pages it changed now differ from chip8's
+    for(std::size_t i = 0; i + PAGE_SIZE < undo.size(); i += PAGE_SIZE + 1) {
+        std::size_t p = undo[i];
+        std::memcpy(&memory[p * PAGE_SIZE], &undo[i + 1], PAGE_SIZE);
+        if(p * PAGE_SIZE < chip8.memory.size()) {
+            chip8.writtenPages[p / 64] |= std::uint64_t(1) << (p % 64);
+        }
+    }
+}
+
+bool RewindBuffer::stepBack(Chip8& chip8) {
+    if(groups.empty()) return false;
+
+    Group& group = groups.back();
+    const Frame& frame = group.frames.back();
+    bool restored = true;
+    if(group.frames.size() == 1) {
+        chip8.loadCoreState(frame.state.data());
+    }
+    else {
+        restored = Rle::decode(frame.state.data(), frame.state.size(), scratch.data(), scratch.size());
+        if(restored) {
+            const std::vector<std::uint8_t>& keyframe = group.frames.front().state;
+            for(std::size_t i = 0; i < scratch.size(); i++) {
+                scratch[i] ^= keyframe[i];
+            }
+            chip8.loadCoreState(scratch.data());
+        }
+    }
+    //memory follows even if the rest could not be decoded, so the stored memory stays the newest frame's
+    restoreMemory(chip8, frame.undo);
+
+    group.frames.pop_back();
+    if(group.frames.empty()) {
+        spareGroups.push_back(std::move(group));
+        groups.pop_back();
+    }
+    --frames;
+    return restored;
+}
+
+void RewindBuffer::clear() {
+    while(!groups.empty()) {
+        spareGroups.push_back(std::move(groups.back()));
+        groups.pop_back();
+    }
+    frames = 0;
+    memory.clear();
+}
+
+std::size_t RewindBuffer::size() const {
+    return frames;
+}
+
+std::size_t RewindBuffer::memoryUsage() const {
+    std::size_t bytes = memory.size();
+    for(const Group& group : groups) {
+        for(const Frame& frame : group.frames) {
+            bytes += frame.state.size() + frame.undo.size();
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "Chip8.h"
+
+/**
+ * Keeps the last N frames of machine state so play can be stepped backwards.
+ *
+ * Memory is held once, as it was in the newest stored frame, and every frame keeps the
+ * pages it changed as they were before. Only the pages in Chip8::writtenPages are compared,
+ * capture() clears them, so the instance must not be shared with a ForkTree.
+ * The rest of the state is kept whole every keyframeInterval frames, the frames in between
+ * as the run-length encoded XOR against their keyframe, which is mostly zeroes.
+ * Whole keyframe groups are dropped once the buffer is full.
+ */
+class RewindBuffer {
+    private:
+        const static std::size_t PAGE_SIZE = Chip8::PAGE_SIZE;
+
+        struct Frame {
+            //Chip8::saveCoreState, whole in the keyframe, XOR against it and encoded in the others
+            std::vector<std::uint8_t> state;
+            //page number and PAGE_SIZE bytes for every page the frame changed, as it was in the frame before
+            std::vector<std::uint8_t> undo;
+        };
+
+        struct Group {
+            //the keyframe first
+            std::vector<Frame> frames;
+        };
+
+        std::size_t capacity;
+        std::size_t keyframeInterval;
+
+        std::deque<Group> groups;
+        std::size_t frames{};
+
+        //memory of the newest stored frame, empty until the first capture after clear()
+        std::vector<std::uint8_t> memory;
+
+        //reused between calls so capturing does not allocate a state per frame
+        std::vector<std::uint8_t> scratch;
+        std::vector<Group> spareGroups;
+
+        void captureMemory(Chip8& chip8, std::vector<std::uint8_t>& undo);
+        void restoreMemory(Chip8& chip8, const std::vector<std::uint8_t>& undo);
+
+    public:
+        /**
+         * @param capacity: Number of frames to keep, e.g. 600 for 10 seconds at 60 Hz
+         * @param keyframeInterval: Frames per full state
+         */
+        explicit RewindBuffer(std::size_t capacity = 600, std::size_t keyframeInterval = 60);
+
+        /**
+         * Store the state at the end of a frame, clears the written pages of chip8
+         */
+        void capture(Chip8& chip8);
+
+        /**
+         * Restore the most recent stored frame and remove it from the buffer
+         * @return: false if there is nothing left to rewind
+         */
+        bool stepBack(Chip8& chip8);
+
+        void clear();
+
+        //number of frames that can be stepped back
+        std::size_t size() const;
+
+        //bytes held by stored frames
+        std::size_t memoryUsage() const;
+};
@@ -0,0 +1,166 @@
+#include "RomLibrary.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "Chip8.h"
+#include "FailStates.h"
+#include "Hash.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHIP8_ROM_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RomLibrary::Mapping::~Mapping() {
+#ifdef CHIP8_ROM_MMAP
+    if(copy.empty() && data != nullptr) {
+        munmap(const_cast<std::uint8_t*>(data), size);
+    }
+#endif
+}
+
+std::uint8_t RomLibrary::mapFile(const std::string& filePath, Mapping& mapping) {
+#ifdef CHIP8_ROM_MMAP
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if(fd >= 0) {
+        struct stat info;
+        if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            close(fd);
+            return FailStates::FILE_NOT_FOUND;
+        }
+        if(info.st_size == 0) {
+            close(fd);
+            return FailStates::ROM_EMPTY;
+        }
+        if(static_cast<std::size_t>(info.st_size) > Chip8::MAX_ROM_SIZE) {
+            close(fd);
+            return FailStates::ROM_TOO_LARGE;
+        }
+
+        void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        //the mapping stays valid after the descriptor is closed
+        close(fd);
+        if(address != MAP_FAILED) {
+            mapping.data = static_cast<const std::uint8_t*>(address);
+            mapping.size = info.st_size;
+            return FailStates::SUCCESS;
+        }
+    }
+#endif
+
+    //no mmap on this host, or it failed: keep a private copy
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if(!file.is_open()) return FailStates::FILE_NOT_FOUND;
+
+    std::streamoff size = file.tellg();
+    if(size <= 0) return FailStates::ROM_EMPTY;
+    if(static_cast<std::size_t>(size) > Chip8::MAX_ROM_SIZE) return FailStates::ROM_TOO_LARGE;
+
+    mapping.copy.resize(size);
+    file.seekg(0, std::ios::beg);
+    if(!file.read(reinterpret_cast<char*>(mapping.copy.data()), size)) return FailStates::FILE_NOT_FOUND;
+    mapping.data = mapping.copy.data();
+    mapping.size = mapping.copy.size();
+    return FailStates::SUCCESS;
+}
+
+std::uint8_t RomLibrary::open(const std::string& filePath, RomImage& image) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto known = byPath.find(filePath);
+        if(known != byPath.end()) {
+            image = imageOf(*known->second);
+            return FailStates::SUCCESS;
+        }
+    }
+
+    //file I/O and hashing without the lock, other threads keep opening and finding ROMs meanwhile
+    auto mapping = std::make_unique<Mapping>();
+    std::uint8_t status = mapFile(filePath, *mapping);
+    if(status != FailStates::SUCCESS) return status;
+    mapping->hash = fnv1a(mapping->data, mapping->size);
+
+    //declared after mapping, so a mapping that is not kept is released after the lock
+    std::lock_guard<std::mutex> lock(mutex);
+    //another thread opened the same path meanwhile
+    auto known = byPath.find(filePath);
+    if(known != byPath.end()) {
+        image = imageOf(*known->second);
+        return FailStates::SUCCESS;
+    }
+
+    const Mapping* stored = mapping.get();
+    auto existing = byHash.find(mapping->hash);
+    if(existing == byHash.end()) {
+        byHash.emplace(mapping->hash, std::move(mapping));
+    }
+    else if(existing->second->size == mapping->size &&
+            std::memcmp(existing->second->data, mapping->data, mapping->size) == 0) {
+        //the same contents are already mapped
+        stored = existing->second.get();
+    }
+    else {
+        //same hash, other contents
+        collisions.push_back(std::move(mapping));
+    }
+    byPath.emplace(filePath, stored);
+
+    image = imageOf(*stored);
+    return FailStates::SUCCESS;
+}
+
+bool RomLibrary::find(std::uint64_t hash, RomImage& image) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = byHash.find(hash);
+    if(found == byHash.end()) return false;
+    image = imageOf(*found->second);
+    return true;
+}
+
+std::size_t RomLibrary::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return byHash.size() + collisions.size();
+}
+
+RomImage RomLibrary::imageOf(const Mapping& mapping) const {
+    RomImage image{mapping.data, mapping.size, mapping.hash};
+    auto quirks = quirksByHash.find(mapping.hash);
+    if(quirks != quirksByHash.end()) image.quirks = quirks->second;
+    return image;
+}
+
+bool RomLibrary::loadMetadata(const std::string& filePath) {
+    std::ifstream file(filePath);
+    if(!file.is_open()) return false;
+
+    //parse everything first, a malformed file adds nothing
+    std::vector<std::pair<std::uint64_t, QuirkProfile>> entries;
+    std::string line;
+    while(std::getline(file, line)) {
+        if(line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::uint64_t hash;
+        std::string name;
+        QuirkProfile profile;
+        if(!(fields >> std::hex >> hash >> name) || !parseQuirkProfile(name, profile)) return false;
+        entries.emplace_back(hash, profile);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for(const auto& entry : entries) {
+        quirksByHash[entry.first] = entry.second;
+    }
+    return true;
+}
+
+void RomLibrary::setQuirks(std::uint64_t hash, QuirkProfile profile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    quirksByHash[hash] = profile;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Quirks.h"
+
+/**
+ * A ROM held by a RomLibrary, valid as long as the library exists
+ */
+struct RomImage {
+    const std::uint8_t* data{nullptr};
+    std::size_t size{};
+    //FNV-1a of the contents
+    std::uint64_t hash{};
+    //from the library metadata, QuirkProfile::Default for ROMs it does not list
+    QuirkProfile quirks{QuirkProfile::Default};
+};
+
+/**
+ * Read-only ROM store shared by many instances.
+ *
+ * Every file is mapped into memory once, validated against Chip8::MAX_ROM_SIZE
+ * (the XO-CHIP limit, Chip8::loadRom checks the smaller one of the selected profile)
+ * and indexed by the hash of its contents, so copies of the same ROM under
+ * different paths share one mapping. Files are compared byte for byte before
+ * they share one, a ROM whose hash collides with another's keeps its own mapping,
+ * open() finds it by path and find() keeps returning the first. Instances then load the image with
+ * Chip8::loadRom(data, size), which does no file I/O.
+ *
+ * Metadata files tell which quirk profile a ROM needs, one ROM per line, '#' starts a comment:
+ *   <content hash in hex> <profile: default, chip8, schip or xochip>
+ * All methods are thread safe.
+ */
+class RomLibrary {
+    private:
+        struct Mapping {
+            const std::uint8_t* data{nullptr};
+            std::size_t size{};
+            //FNV-1a of the contents
+            std::uint64_t hash{};
+            //set when the file could not be mapped and was read into memory instead
+            std::vector<std::uint8_t> copy;
+
+            ~Mapping();
+        };
+
+        mutable std::mutex mutex;
+        //the first ROM opened with each hash
+        std::unordered_map<std::uint64_t, std::unique_ptr<Mapping>> byHash;
+        //ROMs with other contents than the one byHash holds for their hash
+        std::vector<std::unique_ptr<Mapping>> collisions;
+        std::unordered_map<std::string, const Mapping*> byPath;
+        std::unordered_map<std::uint64_t, QuirkProfile> quirksByHash;
+
+        //the image of a mapped ROM, the caller holds the lock
+        RomImage imageOf(const Mapping& mapping) const;
+
+        static std::uint8_t mapFile(const std::string& filePath, Mapping& mapping);
+
+    public:
+        RomLibrary() = default;
+        RomLibrary(const RomLibrary&) = delete;
+        RomLibrary& operator=(const RomLibrary&) = delete;
+
+        /**
+         * Map a ROM file, or return the image already mapped for this path
+         * @return: FailStates::SUCCESS, FILE_NOT_FOUND, ROM_EMPTY or ROM_TOO_LARGE
+         */
+        std::uint8_t open(const std::string& filePath, RomImage& image);
+
+        /**
+         * Look a ROM up by content hash
+         * @return: false if no ROM with this hash was opened
+         */
+        bool find(std::uint64_t hash, RomImage& image) const;
+
+        //number of distinct ROMs
+        std::size_t size() const;
+
+        /**
+         * Add the entries of a metadata file, later entries replace earlier ones for the same hash
+         * @return: false if the file can not be read or a line is malformed
+         */
+        bool loadMetadata(const std::string& filePath);
+
+        /**
+         * Set the quirk profile of the ROM with the given hash, whether it was opened yet or not
+         */
+        void setQuirks(std::uint64_t hash, QuirkProfile profile);
+};
@@ -0,0 +1,60 @@
+#include "Rle.h"
+
+#include <algorithm>
+
+namespace {
+    const std::size_t MIN_RUN = 3;
+    const std::size_t MAX_RUN = 0x7F + MIN_RUN;
+    const std::size_t MAX_LITERALS = 0x80;
+}
+
+void Rle::encode(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& out) {
+    std::size_t i = 0;
+    std::size_t literalStart = 0;
+
+    auto flushLiterals = [&](std::size_t end) {
+        while(literalStart < end) {
+            std::size_t count = std::min(MAX_LITERALS, end - literalStart);
+            out.push_back(count - 1);
+            out.insert(out.end(), data + literalStart, data + literalStart + count);
+            literalStart += count;
+        }
+    };
+
+    while(i < size) {
+        std::size_t run = 1;
+        while(i + run < size && run < MAX_RUN && data[i + run] == data[i]) run++;
+
+        if(run >= MIN_RUN) {
+            flushLiterals(i);
+            out.push_back(0x80 + (run - MIN_RUN));
+            out.push_back(data[i]);
+            i += run;
+            literalStart = i;
+        }
+        else {
+            i += run;
+        }
+    }
+    flushLiterals(size);
+}
+
+bool Rle::decode(const std::uint8_t* data, std::size_t size, std::uint8_t* out, std::size_t outSize) {
+    std::size_t in = 0;
+    std::size_t written = 0;
+    while(in < size) {
+        std::uint8_t control = data[in++];
+        if(control < 0x80) {
+            std::size_t count = control + 1u;
+            if(in + count > size || written + count > outSize) return false;
+            for(std::size_t i = 0; i < count; i++) out[written++] = data[in++];
+        }
+        else {
+            std::size_t count = control - 0x80u + MIN_RUN;
+            if(in >= size || written + count > outSize) return false;
+            std::uint8_t value = data[in++];
+            for(std::size_t i = 0; i < count; i++) out[written++] = value;
+        }
+    }
+    return written == outSize;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * PackBits-style run-length coding, fast and good at the long zero runs
+ * of CHIP-8 memory, displays and XOR deltas.
+ *
+ * Control byte c < 0x80: c + 1 literal bytes follow
+ * Control byte c >= 0x80: the next byte repeats c - 0x80 + 3 times
+ */
+struct Rle {
+    Rle() = delete;
+    ~Rle() = delete;
+
+    /**
+     * Append the encoded form of data to out
+     */
+    static void encode(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& out);
+
+    /**
+     * Decode exactly outSize bytes
+     * @return: false if the input is malformed or does not decode to outSize bytes
+     */
+    static bool decode(const std::uint8_t* data, std::size_t size, std::uint8_t* out, std::size_t outSize);
+};
@@ -0,0 +1,64 @@
+#include "StateFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "Rle.h"
+
+namespace {
+    //magic, compressed flag + padding, raw size, stored size
+    const std::size_t FILE_HEADER_SIZE = 16;
+}
+
+bool StateFile::save(const Chip8& chip8, const std::string& filePath, bool compressed) {
+    std::vector<std::uint8_t> state = chip8.saveState();
+
+    std::vector<std::uint8_t> file(FILE_HEADER_SIZE);
+    if(compressed) {
+        Rle::encode(state.data(), state.size(), file);
+    }
+    else {
+        file.resize(FILE_HEADER_SIZE + state.size());
+        std::memcpy(file.data() + FILE_HEADER_SIZE, state.data(), state.size());
+    }
+
+    std::uint32_t magic = FILE_MAGIC;
+    std::uint32_t flags = compressed ? 1 : 0;
+    std::uint32_t rawSize = state.size();
+    std::uint32_t storedSize = file.size() - FILE_HEADER_SIZE;
+    std::memcpy(file.data(), &magic, 4);
+    std::memcpy(file.data() + 4, &flags, 4);
+    std::memcpy(file.data() + 8, &rawSize, 4);
+    std::memcpy(file.data() + 12, &storedSize, 4);
+
+    std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+    if(!out.is_open()) return false;
+    out.write(reinterpret_cast<const char*>(file.data()), file.size());
+    return out.good();
+}
+
+bool StateFile::load(Chip8& chip8, const std::string& filePath) {
+    std::ifstream in(filePath, std::ios::binary);
+    if(!in.is_open()) return false;
+
+    std::vector<std::uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if(file.size() < FILE_HEADER_SIZE) return false;
+
+    std::uint32_t magic, flags, rawSize, storedSize;
+    std::memcpy(&magic, file.data(), 4);
+    std::memcpy(&flags, file.data() + 4, 4);
+    std::memcpy(&rawSize, file.data() + 8, 4);
+    std::memcpy(&storedSize, file.data() + 12, 4);
+    if(magic != FILE_MAGIC || storedSize != file.size() - FILE_HEADER_SIZE || rawSize != Chip8::stateSize()) {
+        return false;
+    }
+
+    const std::uint8_t* stored = file.data() + FILE_HEADER_SIZE;
+    if(flags & 1u) {
+        std::vector<std::uint8_t> state(rawSize);
+        if(!Rle::decode(stored, storedSize, state.data(), state.size())) return false;
+        return chip8.loadState(state.data(), state.size());
+    }
+    return chip8.loadState(stored, storedSize);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "Chip8.h"
+
+/**
+ * On-disk save states: a small file header and the Chip8::saveState
+ * buffer, optionally run-length compressed (typically 10x smaller)
+ */
+struct StateFile {
+    StateFile() = delete;
+    ~StateFile() = delete;
+
+    const static std::uint32_t FILE_MAGIC = 0x46533843; //"C8SF"
+
+    /**
+     * @return: false if the file can not be written
+     */
+    static bool save(const Chip8& chip8, const std::string& filePath, bool compressed = true);
+
+    /**
+     * @return: false if the file can not be read or is not a valid save state
+     */
+    static bool load(Chip8& chip8, const std::string& filePath);
+};
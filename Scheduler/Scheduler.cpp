@@ -0,0 +1,97 @@
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+Scheduler::Scheduler(double frequency) : frequency(frequency) {
+    reset();
+}
+
+void Scheduler::setFrequency(double newFrequency) {
+    //restart the instruction schedule from the current frame
+    frequency = newFrequency;
+    frame = 0;
+    scheduledInstructions = 0;
+}
+
+double Scheduler::getFrequency() const {
+    return frequency;
+}
+
+std::uint64_t Scheduler::instructionsForFrame() {
+    ++frame;
+    auto target = static_cast<std::uint64_t>(std::floor(frame * frequency / FRAME_RATE));
+    std::uint64_t count = target > scheduledInstructions ? target - scheduledInstructions : 0;
+    scheduledInstructions += count;
+    windowInstructions += count;
+    ++windowEmulatedFrames;
+    return count;
+}
+
+void Scheduler::reportIdle(std::uint64_t instructions) {
+    windowIdleInstructions += instructions;
+}
+
+void Scheduler::reset() {
+    start = Clock::now();
+    deadlineFrame = 0;
+    windowStart = start;
+    windowInstructions = 0;
+    windowFrames = 0;
+    windowIdleInstructions = 0;
+    windowEmulatedFrames = 0;
+    windowJitterUs = 0;
+    windowMaxJitterUs = 0;
+}
+
+void Scheduler::waitForNextFrame() {
+    ++deadlineFrame;
+    //computed from the start on every frame, 1/60 s is not a whole number of nanoseconds
+    auto deadline = start + std::chrono::nanoseconds(deadlineFrame * 1000000000ull / FRAME_RATE);
+
+    auto now = Clock::now();
+    if(now < deadline) {
+        std::this_thread::sleep_until(deadline);
+        now = Clock::now();
+    }
+
+    double lateUs = std::chrono::duration<double, std::micro>(now - deadline).count();
+    if(lateUs > 1e6 * MAX_FRAMES_BEHIND / FRAME_RATE) {
+        //the host stalled (debugger, suspend), do not try to catch up
+        auto behind = static_cast<std::uint64_t>(lateUs * FRAME_RATE / 1e6);
+        droppedFrames += behind;
+        deadlineFrame += behind;
+        lateUs = 0;
+    }
+
+    windowJitterUs += lateUs;
+    windowMaxJitterUs = std::max(windowMaxJitterUs, lateUs);
+    ++windowFrames;
+}
+
+bool Scheduler::statsReady() {
+    auto now = Clock::now();
+    double seconds = std::chrono::duration<double>(now - windowStart).count();
+    if(seconds < 1.0) return false;
+
+    lastStats.instructionsPerSecond = windowInstructions / seconds;
+    lastStats.meanJitterUs = windowFrames > 0 ? windowJitterUs / windowFrames : 0;
+    lastStats.maxJitterUs = windowMaxJitterUs;
+    lastStats.droppedFrames = droppedFrames;
+    lastStats.idleFraction = windowInstructions > 0 ? double(windowIdleInstructions) / windowInstructions : 0;
+    lastStats.speedMultiplier = windowEmulatedFrames / (seconds * FRAME_RATE);
+
+    windowStart = now;
+    windowInstructions = 0;
+    windowFrames = 0;
+    windowIdleInstructions = 0;
+    windowEmulatedFrames = 0;
+    windowJitterUs = 0;
+    windowMaxJitterUs = 0;
+    return true;
+}
+
+const SchedulerStats& Scheduler::getStats() const {
+    return lastStats;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+
+struct SchedulerStats {
+    //instructions per second over the last reporting window
+    double instructionsPerSecond{};
+    //how late the frames started after their deadline, in microseconds
+    double meanJitterUs{};
+    double maxJitterUs{};
+    //frames given up after the host fell too far behind
+    std::uint64_t droppedFrames{};
+    //share of the scheduled instructions the core skipped in idle loops
+    double idleFraction{};
+    //emulated time over host time, 1 when running in real time
+    double speedMultiplier{};
+};
+
+/**
+ * Paces emulation in 60 Hz frames on the monotonic clock.
+ * Every frame runs the number of instructions the clock frequency asks for,
+ * the fractional part is carried to the next frame so nothing is lost,
+ * and the host thread sleeps until the deadline of the next frame.
+ */
+class Scheduler {
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        double frequency;
+
+        //emulated frames since start, instruction targets are computed from it so they never drift
+        std::uint64_t frame{};
+        std::uint64_t scheduledInstructions{};
+
+        Clock::time_point start;
+        std::uint64_t deadlineFrame{};
+
+        //statistics of the current reporting window
+        Clock::time_point windowStart;
+        std::uint64_t windowInstructions{};
+        std::uint64_t windowFrames{};
+        std::uint64_t windowIdleInstructions{};
+        std::uint64_t windowEmulatedFrames{};
+        double windowJitterUs{};
+        double windowMaxJitterUs{};
+        std::uint64_t droppedFrames{};
+        SchedulerStats lastStats;
+
+    public:
+        const static unsigned FRAME_RATE = 60;
+
+        //behind by more than this many frames, the schedule is restarted instead of catching up
+        const static unsigned MAX_FRAMES_BEHIND = 5;
+
+        /**
+         * @param frequency: Instructions per second
+         */
+        explicit Scheduler(double frequency);
+
+        void setFrequency(double newFrequency);
+        double getFrequency() const;
+
+        /**
+         * Number of instructions to execute in the next frame
+         */
+        std::uint64_t instructionsForFrame();
+
+        /**
+         * Report instructions of this frame that the core skipped in an idle loop (Chip8::idleCycles),
+         * the host thread then spends them asleep until the next frame
+         */
+        void reportIdle(std::uint64_t instructions);
+
+        /**
+         * Start (or restart) the real-time schedule from now
+         */
+        void reset();
+
+        /**
+         * Sleep until the next frame is due
+         */
+        void waitForNextFrame();
+
+        /**
+         * @return: true once per second, when a new window of statistics is available
+         */
+        bool statsReady();
+        const SchedulerStats& getStats() const;
+};
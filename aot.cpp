@@ -0,0 +1,138 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "AotRunner.h"
+#include "Chip8.h"
+#include "Scheduler.h"
+
+static void printUsage() {
+    std::cout << "usage: Chip8Aot [--cycles N] [--frequency HZ] [--seed N] [--verify] [--compare]" << std::endl;
+    std::cout << "  runs the ROM recompiled into this binary, the output matches Chip8Batch for the same ROM" << std::endl;
+    std::cout << "  --verify checks every block against Chip8::cycle" << std::endl;
+    std::cout << "  --compare also runs the interpreter and the threaded engine and checks the hashes agree" << std::endl;
+}
+
+struct RunResult {
+    std::uint64_t registersHash;
+    std::uint64_t memoryHash;
+    std::uint64_t displayHash;
+    std::uint64_t idleCycles;
+    double instructionsPerSecond;
+};
+
+/**
+ * Emulated 60 Hz frames like Chip8Batch: a frame of instructions, then one timer tick
+ * @param execute: Runs n instructions on chip8
+ */
+static RunResult runFrames(Chip8& chip8, std::uint64_t cycleBudget, double frequency,
+                           const std::function<void(std::uint64_t)>& execute) {
+    Scheduler frames(frequency);
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t cycle = 0;
+    while(cycle < cycleBudget) {
+        std::uint64_t frameEnd = std::min(cycleBudget, cycle + frames.instructionsForFrame());
+        execute(frameEnd - cycle);
+        cycle = frameEnd;
+        chip8.tickTimers();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return {
+        chip8.registersHash(), chip8.memoryHash(), chip8.displayHash(),
+        chip8.idleCycles, seconds > 0 ? cycleBudget / seconds : 0.0
+    };
+}
+
+int main(int argc, char** argv) {
+    std::uint64_t cycleBudget = 1000000;
+    double frequency = 500;
+    std::uint64_t seed = 0;
+    bool verify = false;
+    bool compare = false;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--cycles" && i + 1 < argc) {
+            cycleBudget = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--frequency" && i + 1 < argc) {
+            frequency = std::strtod(argv[++i], nullptr);
+            if(frequency <= 0) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if(arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 0);
+        }
+        else if(arg == "--verify") {
+            verify = true;
+        }
+        else if(arg == "--compare") {
+            compare = true;
+        }
+        else {
+            printUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    const AotProgram& program = RECOMPILED_PROGRAM;
+
+    Chip8 chip8(seed);
+    chip8.setQuirks(program.quirks);
+    chip8.loadRom(program.rom, program.romSize);
+    AotRunner runner(chip8, program);
+    runner.setVerify(verify);
+
+    RunResult result = runFrames(chip8, cycleBudget, frequency, [&](std::uint64_t n) { runner.run(n); });
+    const AotStats& stats = runner.getStats();
+
+    int failed = 0;
+    if(stats.mismatches > 0) {
+        std::printf("MISMATCH %s: %llu blocks differ from the interpreter, the first at %04X\n",
+                    program.romName, (unsigned long long)stats.mismatches, stats.firstMismatchPc);
+        failed = 1;
+    }
+    std::printf(
+            "OK %s quirks=%s cycles=%llu regs=%016llx mem=%016llx display=%016llx idle=%llu ips=%.0f\n",
+            program.romName, quirkProfileName(program.quirks),
+            (unsigned long long)cycleBudget,
+            (unsigned long long)result.registersHash,
+            (unsigned long long)result.memoryHash,
+            (unsigned long long)result.displayHash,
+            (unsigned long long)result.idleCycles,
+            result.instructionsPerSecond
+    );
+    std::printf(
+            "native=%llu interpreted=%llu invalidated=%llu blocks=%zu\n",
+            (unsigned long long)stats.nativeInstructions,
+            (unsigned long long)stats.interpretedInstructions,
+            (unsigned long long)stats.blocksInvalidated,
+            program.blockCount
+    );
+
+    if(compare) {
+        for(Chip8::Engine engine : {Chip8::Engine::Interpreter, Chip8::Engine::Threaded}) {
+            Chip8 reference(seed);
+            reference.setEngine(engine);
+            reference.setQuirks(program.quirks);
+            reference.loadRom(program.rom, program.romSize);
+            RunResult expected = runFrames(reference, cycleBudget, frequency, [&](std::uint64_t n) { reference.run(n); });
+
+            bool matched = expected.registersHash == result.registersHash &&
+                           expected.memoryHash == result.memoryHash &&
+                           expected.displayHash == result.displayHash;
+            const char* name = engine == Chip8::Engine::Interpreter ? "interpreter" : "threaded";
+            std::printf("%s %s ips=%.0f speedup=%.2f\n",
+                        matched ? "SAME" : "MISMATCH", name, expected.instructionsPerSecond,
+                        expected.instructionsPerSecond > 0 ? result.instructionsPerSecond / expected.instructionsPerSecond : 0.0);
+            if(!matched) failed = 1;
+        }
+    }
+    return failed;
+}
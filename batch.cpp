@@ -0,0 +1,230 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BatchRunner.h"
+
+static void printUsage() {
+    std::cout << "usage: Chip8Batch [--threads N] [--cycles N] [--frequency HZ] [--seed N] [--quirks default|chip8|schip|xochip] [--rom-db FILE] [--engine interpreter|cache|threaded|jit] [--verify] [--no-idle-skip] [--profile PREFIX] [--wav PREFIX] [--jobs FILE] [--replay ROM LOG]... [ROM...]" << std::endl;
+    std::cout << "  jobs file: one \"<rom> [cycles] [input script]\" per line" << std::endl;
+    std::cout << "  --profile writes PREFIX<job>.json/.csv/.flat.txt, needs a build with -DCHIP8_PROFILE=ON" << std::endl;
+    std::cout << "  --wav renders the sound of every job into PREFIX<job>.wav" << std::endl;
+    std::cout << "  --rom-db reads the quirk profile of each ROM from a \"<hash> <profile>\" file, --quirks overrides it" << std::endl;
+    std::cout << "  --replay runs a recorded input log to its end and checks the recorded hashes" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = std::thread::hardware_concurrency();
+    std::uint64_t defaultCycles = 1000000;
+    double frequency = 500;
+    std::vector<BatchJob> jobs;
+    std::vector<std::string> roms;
+    std::vector<std::pair<std::string, std::string>> replays;
+    std::uint64_t seed = 0;
+    bool hasQuirks = false;
+    QuirkProfile quirks = QuirkProfile::Default;
+    std::string romDatabase;
+    std::string jobsFile;
+    Chip8::Engine engine = Chip8::Engine::Interpreter;
+    bool jit = false;
+    bool verify = false;
+    bool idleSkipping = true;
+    std::string profilePrefix;
+    std::string wavPrefix;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--threads" && i + 1 < argc) {
+            threads = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--cycles" && i + 1 < argc) {
+            defaultCycles = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--frequency" && i + 1 < argc) {
+            frequency = std::strtod(argv[++i], nullptr);
+            if(frequency <= 0) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if(arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 0);
+        }
+        else if(arg == "--quirks" && i + 1 < argc) {
+            if(!parseQuirkProfile(argv[++i], quirks)) {
+                printUsage();
+                return 1;
+            }
+            hasQuirks = true;
+        }
+        else if(arg == "--rom-db" && i + 1 < argc) {
+            romDatabase = argv[++i];
+        }
+        else if(arg == "--replay" && i + 2 < argc) {
+            replays.emplace_back(argv[i + 1], argv[i + 2]);
+            i += 2;
+        }
+        else if(arg == "--engine" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if(name == "interpreter") engine = Chip8::Engine::Interpreter;
+            else if(name == "cache") engine = Chip8::Engine::DecodeCache;
+            else if(name == "threaded") engine = Chip8::Engine::Threaded;
+            else if(name == "jit") jit = true;
+            else {
+                printUsage();
+                return 1;
+            }
+        }
+        else if(arg == "--verify") {
+            verify = true;
+        }
+        else if(arg == "--no-idle-skip") {
+            idleSkipping = false;
+        }
+        else if(arg == "--profile" && i + 1 < argc) {
+            profilePrefix = argv[++i];
+#ifndef CHIP8_PROFILE
+            std::cout << "ERROR: --profile needs a build configured with -DCHIP8_PROFILE=ON" << std::endl;
+            return 1;
+#endif
+        }
+        else if(arg == "--wav" && i + 1 < argc) {
+            wavPrefix = argv[++i];
+        }
+        else if(arg == "--jobs" && i + 1 < argc) {
+            jobsFile = argv[++i];
+        }
+        else if(arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        }
+        else {
+            roms.push_back(arg);
+        }
+    }
+
+    if(!jobsFile.empty()) {
+        std::ifstream file(jobsFile);
+        if(!file.is_open()) {
+            std::cout << "ERROR: jobs file not found" << std::endl;
+            return FailStates::FILE_NOT_FOUND;
+        }
+        std::string line;
+        while(std::getline(file, line)) {
+            if(line.empty() || line[0] == '#') continue;
+            std::istringstream fields(line);
+            BatchJob job;
+            job.cycleBudget = defaultCycles;
+            job.frequency = frequency;
+            job.seed = seed;
+            job.hasQuirks = hasQuirks;
+            job.quirks = quirks;
+            job.engine = engine;
+            job.jit = jit;
+            job.verifyJit = verify;
+            job.idleSkipping = idleSkipping;
+            fields >> job.romPath >> job.cycleBudget >> job.inputScript;
+            jobs.push_back(job);
+        }
+    }
+    for(const auto& rom : roms) {
+        BatchJob job;
+        job.romPath = rom;
+        job.cycleBudget = defaultCycles;
+        job.frequency = frequency;
+        job.seed = seed;
+        job.hasQuirks = hasQuirks;
+        job.quirks = quirks;
+        job.engine = engine;
+        job.jit = jit;
+        job.verifyJit = verify;
+        job.idleSkipping = idleSkipping;
+        jobs.push_back(job);
+    }
+    for(const auto& replay : replays) {
+        BatchJob job;
+        job.romPath = replay.first;
+        job.inputScript = replay.second;
+        job.cycleBudget = defaultCycles;
+        job.frequency = frequency;
+        job.seed = seed;
+        job.hasQuirks = hasQuirks;
+        job.quirks = quirks;
+        job.engine = engine;
+        job.jit = jit;
+        job.verifyJit = verify;
+        job.idleSkipping = idleSkipping;
+        jobs.push_back(job);
+    }
+
+    if(!profilePrefix.empty()) {
+        for(std::size_t i = 0; i < jobs.size(); i++) {
+            jobs[i].profilePrefix = profilePrefix + std::to_string(i);
+        }
+    }
+    if(!wavPrefix.empty()) {
+        for(std::size_t i = 0; i < jobs.size(); i++) {
+            jobs[i].wavPath = wavPrefix + std::to_string(i) + ".wav";
+        }
+    }
+
+    if(jobs.empty()) {
+        printUsage();
+        return FailStates::ROM_NOT_LOADED;
+    }
+
+    BatchRunner runner(threads);
+    if(!romDatabase.empty() && !runner.romLibrary().loadMetadata(romDatabase)) {
+        std::cout << "ERROR: invalid ROM database" << std::endl;
+        return FailStates::FILE_NOT_FOUND;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<BatchResult> results = runner.run(jobs);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::uint64_t totalCycles = 0;
+    std::size_t failed = 0;
+    for(const auto& result : results) {
+        if(!result.ok) {
+            std::printf("FAIL %s: %s\n", result.romPath.c_str(), result.error.c_str());
+            ++failed;
+            continue;
+        }
+        totalCycles += result.cycles;
+        if(result.jitMismatches > 0) {
+            std::printf("MISMATCH %s: %llu JIT blocks differ from the interpreter\n",
+                        result.romPath.c_str(), (unsigned long long)result.jitMismatches);
+            ++failed;
+        }
+        if(result.replayChecked && !result.replayMatched) {
+            std::printf("MISMATCH %s: final state differs from the recorded input log\n", result.romPath.c_str());
+            ++failed;
+        }
+        std::printf(
+                "OK %s quirks=%s cycles=%llu regs=%016llx mem=%016llx display=%016llx idle=%llu ips=%.0f\n",
+                result.romPath.c_str(),
+                quirkProfileName(result.quirks),
+                (unsigned long long)result.cycles,
+                (unsigned long long)result.registersHash,
+                (unsigned long long)result.memoryHash,
+                (unsigned long long)result.displayHash,
+                (unsigned long long)result.idleCycles,
+                result.instructionsPerSecond
+        );
+    }
+
+    std::printf(
+            "jobs=%zu failed=%zu threads=%u cycles=%llu wall=%.3fs aggregate_ips=%.0f\n",
+            results.size(), failed, runner.threadCount(),
+            (unsigned long long)totalCycles, wall, wall > 0 ? totalCycles / wall : 0.0
+    );
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,284 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "Benchmark.h"
+#include "Chip8.h"
+#include "Jit.h"
+#include "LockstepEngine.h"
+#include "SyntheticRoms.h"
+#include "VectorEnv.h"
+
+static void printUsage() {
+    std::cout << "usage: Chip8Bench [--min-time SECONDS] [--repetitions N] [--filter TEXT] [--format json|csv] [--output FILE]" << std::endl;
+    std::cout << "  results go to stdout (or FILE), progress to stderr" << std::endl;
+}
+
+/**
+ * Call the handler of one opcode in a loop, without fetch and dispatch
+ * @param index: I before every call, so memory instructions keep writing the same bytes
+ * @param hires: Run in the 128x64 mode of the extended profiles
+ */
+static void benchOpcode(BenchmarkSuite& suite, const std::string& name, std::uint16_t opcode,
+                        std::uint8_t vx = 0x5A, std::uint8_t vy = 0x3C, std::uint16_t index = 0x300,
+                        QuirkProfile quirks = QuirkProfile::Default, bool hires = false) {
+    auto chip8 = std::make_unique<Chip8>(1);
+    chip8->setQuirks(quirks);
+    chip8->display.setHires(hires);
+    for(std::uint8_t i = 0; i < chip8->registers.size(); i++) {
+        chip8->registers[i] = static_cast<std::uint8_t>(i * 17 + 1);
+    }
+    //sprite data for DXYN, enough for a 16x16 DXY0
+    std::fill(chip8->memory.begin() + index, chip8->memory.begin() + index + 32, 0xFF);
+
+    Chip8::DecodedOp op = chip8->decode(opcode);
+    chip8->opcode = opcode;
+    chip8->args = op.args;
+    chip8->registers[op.args.x] = vx;
+    chip8->registers[op.args.y] = vy;
+
+    Chip8* instance = chip8.get();
+    suite.run(name, [=](std::uint64_t iterations) {
+        for(std::uint64_t i = 0; i < iterations; i++) {
+            instance->vi = index;
+            (instance->*op.handler)();
+        }
+    });
+}
+
+static std::unique_ptr<Chip8> romInstance(const SyntheticRom& rom, Chip8::Engine engine) {
+    auto chip8 = std::make_unique<Chip8>(1);
+    chip8->setEngine(engine);
+    //the synthetic ROMs never idle, and the benchmark measures execution
+    chip8->idleSkipping = false;
+    chip8->loadRom(rom.data, rom.size);
+    return chip8;
+}
+
+/**
+ * Run a ROM on lockstep lanes and on interpreter instances with the same seeds,
+ * timing the lockstep engine is pointless if its lanes end somewhere else
+ * @return: false if a lane differs, reported on stderr
+ */
+static bool verifyLockstep(const SyntheticRom& rom, bool avx2) {
+    const std::size_t lanes = 64;
+    const std::uint64_t cycles = 1000;
+    LockstepEngine lockstep(lanes);
+    lockstep.setAvx2(avx2);
+    lockstep.loadRom(rom.data, rom.size);
+    for(std::size_t i = 0; i < lanes; i++) lockstep.seedRandom(i, i);
+    lockstep.run(cycles);
+
+    auto lane = std::make_unique<Chip8>(0);
+    for(std::size_t i = 0; i < lanes; i++) {
+        std::unique_ptr<Chip8> reference = romInstance(rom, Chip8::Engine::Interpreter);
+        reference->seedRandom(i);
+        reference->run(cycles);
+        lockstep.exportLane(i, *lane);
+        if(lane->registersHash() != reference->registersHash() || lane->memoryHash() != reference->memoryHash() ||
+           lane->displayHash() != reference->displayHash()) {
+            std::cerr << "FAIL lockstep/" << rom.name << (avx2 ? "/avx2" : "/generic") << ": lane " << i
+                      << " differs from the interpreter" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    double minTime = 0.2;
+    unsigned repetitions = 3;
+    std::string filter;
+    std::string format = "json";
+    std::string outputPath;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--min-time" && i + 1 < argc) {
+            minTime = std::strtod(argv[++i], nullptr);
+        }
+        else if(arg == "--repetitions" && i + 1 < argc) {
+            repetitions = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else if(arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+            if(format != "json" && format != "csv") {
+                printUsage();
+                return 1;
+            }
+        }
+        else if(arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else {
+            printUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    BenchmarkSuite suite(minTime, repetitions, filter);
+
+    //ALU handlers, VX = 0x5A and VY = 0x3C
+    const char* aluNames[] = {"8XY0", "8XY1", "8XY2", "8XY3", "8XY4", "8XY5", "8XY6", "8XY7"};
+    for(std::uint16_t n = 0; n < 8; n++) {
+        benchOpcode(suite, std::string("op/") + aluNames[n], 0x8010 | n);
+    }
+    benchOpcode(suite, "op/8XYE", 0x801E);
+
+    //DXYN: height, column and row of the sprite
+    struct DrawCase { const char* name; std::uint8_t height; std::uint8_t x; std::uint8_t y; };
+    const DrawCase drawCases[] = {
+            {"draw/DXY1_aligned", 1, 0, 0},
+            {"draw/DXY8_aligned", 8, 8, 4},
+            {"draw/DXY8_unaligned", 8, 3, 4},
+            {"draw/DXYF_unaligned", 15, 29, 2},
+            {"draw/DXYF_clipped", 15, 60, 24},
+            {"draw/DXY5_wrapped", 5, 70, 40}
+    };
+    for(const DrawCase& draw : drawCases) {
+        benchOpcode(suite, draw.name, 0xD010 | draw.height, draw.x, draw.y);
+    }
+
+    //SUPER-CHIP sprites and scrolls on both planes of the hires screen
+    benchOpcode(suite, "draw/DXY0_hires", 0xD010, 29, 2, 0x300, QuirkProfile::XoChip, true);
+    benchOpcode(suite, "draw/DXY8_hires", 0xD018, 93, 40, 0x300, QuirkProfile::SuperChip, true);
+    benchOpcode(suite, "scroll/00FB_lores", 0x00FB, 0x5A, 0x3C, 0x300, QuirkProfile::SuperChip);
+    benchOpcode(suite, "scroll/00FB_hires", 0x00FB, 0x5A, 0x3C, 0x300, QuirkProfile::SuperChip, true);
+    benchOpcode(suite, "scroll/00FC_hires", 0x00FC, 0x5A, 0x3C, 0x300, QuirkProfile::SuperChip, true);
+    benchOpcode(suite, "scroll/00C4_hires", 0x00C4, 0x5A, 0x3C, 0x300, QuirkProfile::SuperChip, true);
+
+    //memory handlers, all 16 registers for the block transfers
+    benchOpcode(suite, "mem/FX33", 0xF033, 0xFE);
+    benchOpcode(suite, "mem/FX55_V0", 0xF055);
+    benchOpcode(suite, "mem/FX55_VF", 0xFF55);
+    benchOpcode(suite, "mem/FX65_V0", 0xF065);
+    benchOpcode(suite, "mem/FX65_VF", 0xFF65);
+
+    const SyntheticRom& alu = SyntheticRoms::all().front();
+    const std::pair<const char*, Chip8::Engine> engines[] = {
+            {"interpreter", Chip8::Engine::Interpreter},
+            {"cache", Chip8::Engine::DecodeCache},
+            {"threaded", Chip8::Engine::Threaded}
+    };
+
+    //the full fetch, decode and dispatch path of a single cycle() call
+    for(const auto& engine : engines) {
+        std::shared_ptr<Chip8> chip8 = romInstance(alu, engine.second);
+        suite.run(std::string("dispatch/cycle/") + engine.first, [chip8](std::uint64_t iterations) {
+            for(std::uint64_t i = 0; i < iterations; i++) chip8->cycle();
+        });
+    }
+
+    //starting over with a ROM: a new instance against reset() of a used one,
+    //each reset follows 64 instructions so the memory the ROM wrote has to be restored
+    suite.run("instance/construct", [&alu](std::uint64_t iterations) {
+        for(std::uint64_t i = 0; i < iterations; i++) {
+            auto chip8 = std::make_unique<Chip8>(i);
+            chip8->loadRom(alu.data, alu.size);
+        }
+    });
+    std::shared_ptr<Chip8> used = romInstance(alu, Chip8::Engine::Interpreter);
+    suite.run("instance/reset", [used](std::uint64_t iterations) {
+        for(std::uint64_t i = 0; i < iterations; i++) {
+            used->run(64);
+            used->reset(i);
+        }
+    });
+
+    //end to end instructions per second of every synthetic ROM on every engine
+    for(const SyntheticRom& rom : SyntheticRoms::all()) {
+        for(const auto& engine : engines) {
+            std::shared_ptr<Chip8> chip8 = romInstance(rom, engine.second);
+            suite.run(std::string("rom/") + rom.name + "/" + engine.first, [chip8](std::uint64_t iterations) {
+                chip8->run(iterations);
+            });
+        }
+        if(Jit::supported()) {
+            std::shared_ptr<Chip8> chip8 = romInstance(rom, Chip8::Engine::Interpreter);
+            std::shared_ptr<Jit> jit = std::make_shared<Jit>(*chip8);
+            suite.run(std::string("rom/") + rom.name + "/jit", [chip8, jit](std::uint64_t iterations) {
+                jit->run(iterations);
+            });
+        }
+    }
+
+    //many seeded instances of one ROM: the lockstep engine against independent objects, per lane instruction.
+    //Every ROM is checked against the interpreter first
+    int failed = 0;
+    const std::size_t instances = 256;
+    for(const SyntheticRom& rom : SyntheticRoms::all()) {
+        auto cyclesFor = [instances](std::uint64_t iterations) {
+            return (iterations + instances - 1) / instances;
+        };
+
+        std::vector<bool> vectorModes = {false};
+        if(LockstepEngine::avx2Supported()) vectorModes.push_back(true);
+        for(bool avx2 : vectorModes) {
+            if(!verifyLockstep(rom, avx2)) failed = 1;
+            std::shared_ptr<LockstepEngine> lockstep = std::make_shared<LockstepEngine>(instances);
+            lockstep->setAvx2(avx2);
+            lockstep->loadRom(rom.data, rom.size);
+            for(std::size_t i = 0; i < instances; i++) lockstep->seedRandom(i, i);
+            suite.run(std::string("lockstep/") + rom.name + (avx2 ? "/avx2" : "/generic"), [=](std::uint64_t iterations) {
+                lockstep->run(cyclesFor(iterations));
+            });
+        }
+
+        std::shared_ptr<std::vector<Chip8>> independent = std::make_shared<std::vector<Chip8>>();
+        independent->reserve(instances);
+        for(std::size_t i = 0; i < instances; i++) {
+            independent->emplace_back(i);
+            independent->back().setEngine(Chip8::Engine::Threaded);
+            independent->back().idleSkipping = false;
+            independent->back().loadRom(rom.data, rom.size);
+        }
+        suite.run(std::string("independent/") + rom.name + "/threaded", [=](std::uint64_t iterations) {
+            std::uint64_t cycles = cyclesFor(iterations);
+            for(Chip8& chip8 : *independent) chip8.run(cycles);
+        });
+    }
+
+    //agent training: environment steps per second of batches of the draw ROM, 4 frames per step
+    const SyntheticRom& drawRom = SyntheticRoms::all()[1];
+    for(std::size_t count = 1; count <= 4096; count *= 4) {
+        std::shared_ptr<VectorEnv> env = std::make_shared<VectorEnv>(count, EnvConfig{});
+        env->loadRom(drawRom.data, drawRom.size);
+
+        auto observations = std::make_shared<std::vector<std::uint8_t>>(count * env->observationSize());
+        auto rewards = std::make_shared<std::vector<float>>(count);
+        auto dones = std::make_shared<std::vector<std::uint8_t>>(count);
+        EnvBuffers buffers{observations->data(), rewards->data(), dones->data()};
+
+        std::vector<std::uint64_t> seeds(count);
+        auto actions = std::make_shared<std::vector<std::int32_t>>(count);
+        for(std::size_t i = 0; i < count; i++) {
+            seeds[i] = i;
+            (*actions)[i] = static_cast<std::int32_t>(i % env->actionCount());
+        }
+        env->reset(seeds.data(), buffers);
+
+        suite.run("env/" + std::string(drawRom.name) + "/" + std::to_string(count), [=](std::uint64_t iterations) {
+            for(std::uint64_t i = 0; i < (iterations + count - 1) / count; i++) {
+                env->step(actions->data(), 4, buffers);
+            }
+        });
+    }
+
+    std::ofstream file;
+    if(!outputPath.empty()) {
+        file.open(outputPath);
+        if(!file.is_open()) {
+            std::cout << "ERROR: can not write " << outputPath << std::endl;
+            return FailStates::FILE_NOT_FOUND;
+        }
+    }
+    std::ostream& out = outputPath.empty() ? std::cout : file;
+    if(format == "csv") suite.writeCsv(out);
+    else suite.writeJson(out);
+    return failed;
+}
@@ -0,0 +1,138 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Chip8.h"
+#include "ForkTree.h"
+#include "SyntheticRoms.h"
+
+static void printUsage() {
+    std::cout << "usage: Chip8Fork [--depth N] [--branching N] [--cycles N] [--quirks default|chip8|schip|xochip]" << std::endl;
+    std::cout << "  grows a search tree on every synthetic ROM: every level forks N children of the last one," << std::endl;
+    std::cout << "  each runs its cycles with its own key held down, and all states are kept until the end" << std::endl;
+    std::cout << "  reports fork, checkout and commit latency and the memory of the tree against whole Chip8 copies" << std::endl;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static double nanoseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::nano>(duration).count();
+}
+
+static void pressOnly(Chip8& chip8, unsigned key) {
+    chip8.keyPad.fill(false);
+    chip8.keyPad[key % 16] = true;
+}
+
+int main(int argc, char** argv) {
+    unsigned depth = 1000;
+    unsigned branching = 4;
+    std::uint64_t cycles = 100;
+    QuirkProfile quirks = QuirkProfile::Default;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--depth" && i + 1 < argc) {
+            depth = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--branching" && i + 1 < argc) {
+            branching = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--cycles" && i + 1 < argc) {
+            cycles = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--quirks" && i + 1 < argc) {
+            if(!parseQuirkProfile(argv[++i], quirks)) {
+                printUsage();
+                return 1;
+            }
+        }
+        else {
+            printUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if(branching == 0) branching = 1;
+
+    int failed = 0;
+    for(const SyntheticRom& rom : SyntheticRoms::all()) {
+        Chip8 root(1);
+        root.setQuirks(quirks);
+        root.loadRom(rom.data, rom.size);
+
+        ForkTree tree;
+        ForkWorkspace workspace(root);
+        std::vector<ForkTree::StateId> states;
+        states.push_back(tree.capture(root));
+
+        Clock::duration forkTime{}, checkoutTime{}, commitTime{};
+        ForkTree::StateId current = states.front();
+        for(unsigned level = 0; level < depth; level++) {
+            ForkTree::StateId next = current;
+            for(unsigned b = 0; b < branching; b++) {
+                auto start = Clock::now();
+                ForkTree::StateId child = tree.fork(current);
+                auto forked = Clock::now();
+                tree.checkout(child, workspace);
+                auto checkedOut = Clock::now();
+                pressOnly(workspace.chip8, b);
+                workspace.chip8.run(cycles);
+                auto ran = Clock::now();
+                tree.commit(workspace);
+                auto committed = Clock::now();
+
+                forkTime += forked - start;
+                checkoutTime += checkedOut - forked;
+                commitTime += committed - ran;
+                states.push_back(child);
+                if(b == 0) next = child;
+            }
+            current = next;
+        }
+        ForkStats stats = tree.getStats();
+
+        //the first child of every level replayed on a plain Chip8 must end in the same state
+        Chip8 replay(1);
+        replay.setQuirks(quirks);
+        replay.loadRom(rom.data, rom.size);
+        for(unsigned level = 0; level < depth; level++) {
+            pressOnly(replay, 0);
+            replay.run(cycles);
+        }
+        tree.checkout(current, workspace);
+        bool matched = replay.saveState() == workspace.chip8.saveState();
+
+        //what the tree replaces: a whole copy of the machine per state
+        std::vector<Chip8> copies(16, root);
+        const unsigned copyCount = 1000;
+        auto copyStart = Clock::now();
+        for(unsigned i = 0; i < copyCount; i++) {
+            copies[i % copies.size()] = workspace.chip8;
+        }
+        double copyNs = nanoseconds(Clock::now() - copyStart) / copyCount;
+
+        for(ForkTree::StateId state : states) {
+            tree.release(state);
+        }
+        ForkStats released = tree.getStats();
+        //only the shared zero page is left
+        bool leaked = released.states != 0 || released.tables != 0 || released.pages != 1;
+
+        double forks = double(depth) * branching;
+        std::printf(
+                "%s %s depth=%u branching=%u cycles=%llu states=%zu tables=%zu pages=%zu bytes=%zu bytes_per_state=%.0f"
+                " copy_bytes=%zu pages_copied=%llu fork_ns=%.0f checkout_ns=%.0f commit_ns=%.0f copy_ns=%.0f%s\n",
+                matched && !leaked ? "OK" : "FAIL", rom.name, depth, branching, (unsigned long long)cycles,
+                stats.states, stats.tables, stats.pages, stats.bytes, double(stats.bytes) / stats.states,
+                stats.states * sizeof(Chip8), (unsigned long long)stats.pagesCopied,
+                nanoseconds(forkTime) / forks, nanoseconds(checkoutTime) / forks, nanoseconds(commitTime) / forks, copyNs,
+                !matched ? " (replay differs)" : leaked ? " (pages leaked)" : ""
+        );
+        if(!matched || leaked) failed = 1;
+    }
+    return failed;
+}
@@ -1,11 +1,99 @@
 #include <iostream>
+#include <cstdlib>
+#include <string>
 #include "Chip8.h"
 #include <SFML/Graphics.hpp>
 #include "Machine.h"
+#include "RomLibrary.h"
 
-int main() {
-    Machine machine("Chip8 test", 16.f, 500);
-    machine.loadRom("/home/tomislav/Desktop/emudev/Chip8/roms/chip8-test-suite.ch8");
+static void printUsage() {
+    std::cout << "usage: Chip8 [--frequency HZ] [--scale N] [--turbo] [--frame-skip N] [--record FILE] [--quirks default|chip8|schip|xochip] [--rom-db FILE] [--keymap KEYS] [ROM]" << std::endl;
+    std::cout << "  Tab toggles turbo mode, hold Backspace to rewind" << std::endl;
+    std::cout << "  --keymap takes the host keys of chip8 keys 0 to F, the default is x123qweasdzc4rfv" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    float frequency = 500;
+    int scale = 16;
+    bool turbo = false;
+    unsigned frameSkip = 0;
+    std::string recordPath;
+    bool hasQuirks = false;
+    QuirkProfile quirks = QuirkProfile::Default;
+    std::string romDatabase;
+    std::string keymap;
+    std::string romPath = "/home/tomislav/Desktop/emudev/Chip8/roms/chip8-test-suite.ch8";
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--frequency" && i + 1 < argc) {
+            frequency = std::strtof(argv[++i], nullptr);
+        }
+        else if(arg == "--scale" && i + 1 < argc) {
+            scale = std::atoi(argv[++i]);
+        }
+        else if(arg == "--turbo") {
+            turbo = true;
+        }
+        else if(arg == "--frame-skip" && i + 1 < argc) {
+            frameSkip = std::strtoul(argv[++i], nullptr, 10);
+        }
+        //chip8 --record session.log
+        else if(arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        }
+        else if(arg == "--quirks" && i + 1 < argc) {
+            if(!parseQuirkProfile(argv[++i], quirks)) {
+                printUsage();
+                return 1;
+            }
+            hasQuirks = true;
+        }
+        //the profile of the ROM from a "<hash> <profile>" file, --quirks wins
+        else if(arg == "--rom-db" && i + 1 < argc) {
+            romDatabase = argv[++i];
+        }
+        else if(arg == "--keymap" && i + 1 < argc) {
+            keymap = argv[++i];
+        }
+        else if(arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        }
+        else {
+            romPath = arg;
+        }
+    }
+    if(frequency <= 0 || scale <= 0) {
+        printUsage();
+        return 1;
+    }
+
+    Machine machine("Chip8 test", scale, frequency);
+    if(!keymap.empty() && !machine.setKeymap(keymap)) {
+        printUsage();
+        return 1;
+    }
+    if(!hasQuirks && !romDatabase.empty()) {
+        RomLibrary library;
+        RomImage image;
+        if(!library.loadMetadata(romDatabase)) {
+            std::cout << "ERROR: invalid ROM database" << std::endl;
+        }
+        else if(library.open(romPath, image) == FailStates::SUCCESS) {
+            quirks = image.quirks;
+        }
+    }
+    //before loading, the profile decides how large a ROM can be
+    machine.setQuirks(quirks);
+    std::uint8_t status = machine.loadRom(romPath);
+    if(status != FailStates::SUCCESS) {
+        return status;
+    }
+    machine.setTurbo(turbo, frameSkip);
+    if(!recordPath.empty()) {
+        machine.recordInput(recordPath);
+    }
     machine.runLoop();
     return 0;
 }
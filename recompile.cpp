@@ -0,0 +1,81 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Chip8.h"
+#include "Recompiler.h"
+
+static void printUsage() {
+    std::cout << "usage: Chip8Recompile [--quirks default|chip8|schip|xochip] ROM OUTPUT.cpp" << std::endl;
+    std::cout << "  translates ROM into C++, build it into Chip8Aot with cmake -DCHIP8_AOT_ROM=ROM" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    QuirkProfile quirks = QuirkProfile::Default;
+    std::string romPath;
+    std::string outputPath;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--quirks" && i + 1 < argc) {
+            if(!parseQuirkProfile(argv[++i], quirks)) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if(arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        }
+        else if(romPath.empty()) {
+            romPath = arg;
+        }
+        else if(outputPath.empty()) {
+            outputPath = arg;
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if(romPath.empty() || outputPath.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    //the memory exactly as a run of the ROM starts with
+    Chip8 chip8(0);
+    chip8.setQuirks(quirks);
+    std::uint8_t status = chip8.loadRom(romPath);
+    if(status != FailStates::SUCCESS) {
+        std::cout << "ERROR: can not load the ROM" << std::endl;
+        return status;
+    }
+
+    Recompiler recompiler(chip8);
+    recompiler.analyze();
+
+    std::ofstream out(outputPath);
+    if(!out.is_open()) {
+        std::cout << "ERROR: can not write " << outputPath << std::endl;
+        return FailStates::FILE_NOT_FOUND;
+    }
+    //the path the ROM was given by, without its directories
+    std::string romName = romPath.substr(romPath.find_last_of("/\\") + 1);
+    recompiler.emit(out, romName);
+    out.close();
+    if(!out) {
+        std::cout << "ERROR: can not write " << outputPath << std::endl;
+        return FailStates::FILE_NOT_FOUND;
+    }
+
+    const RecompilerStats& stats = recompiler.getStats();
+    std::printf(
+            "%s quirks=%s blocks=%zu instructions=%zu interpreted=%zu reached=%zu/%u bytes computed_jumps=%zu\n",
+            romName.c_str(), quirkProfileName(quirks),
+            stats.blocks, stats.instructions, stats.interpretedInstructions,
+            stats.reachedBytes, static_cast<unsigned>(chip8.program_size), stats.computedJumps
+    );
+    return 0;
+}